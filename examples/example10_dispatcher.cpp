@@ -0,0 +1,96 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ *  SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ *  OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ *  CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Get the first 5 accounts of an instance concurrently (/api/v1/accounts/:id).
+
+#if __has_include("mastodonpp.hpp")
+#    include "mastodonpp.hpp" // We're building mastodonpp.
+#else
+#    include <mastodonpp/mastodonpp.hpp> // We're building outside mastodonpp.
+#endif
+
+#include <future>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace masto = mastodonpp;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::future;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+int main(int argc, char *argv[])
+{
+    const vector<string_view> args(argv, argv + argc);
+    if (args.size() <= 1)
+    {
+        cerr << "Usage: " << args[0] << " <instance hostname>\n";
+        return 1;
+    }
+
+    try
+    {
+        // Initialize an Instance.
+        masto::Instance instance{args[1], {}};
+
+        // Initialize a Dispatcher. It starts a thread that makes the requests.
+        masto::Dispatcher dispatcher{instance};
+
+        // Queue the requests. They all run at the same time.
+        vector<future<masto::answer_type>> answers;
+        for (auto id{1}; id <= 5; ++id)
+        {
+            const string id_str{to_string(id)};
+            answers.push_back(dispatcher.submit(masto::http_method::GET,
+                                                masto::API::v1::accounts_id,
+                                                {{"id", id_str}}));
+        }
+
+        // Wait for the answers and print the beginning of each.
+        for (auto &answer_future : answers)
+        {
+            const auto answer{answer_future.get()};
+            if (answer)
+            {
+                cout << answer.body.substr(0, 70) << " …" << endl;
+            }
+            else if (answer.curl_error_code == 0)
+            {
+                // If it is no libcurl error, it must be an HTTP error.
+                cerr << "HTTP status: " << answer.http_status << endl;
+            }
+            else
+            {
+                // Network errors like “Couldn't resolve host.”.
+                cerr << "libcurl error " << to_string(answer.curl_error_code)
+                     << ": " << answer.error_message << endl;
+            }
+        }
+    }
+    catch (const masto::CURLException &e)
+    {
+        // Only libcurl errors that are not network errors will be thrown.
+        // There went probably something wrong with the initialization.
+        cerr << e.what() << endl;
+    }
+
+    return 0;
+}
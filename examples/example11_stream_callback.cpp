@@ -0,0 +1,96 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ *  SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ *  OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ *  CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Print the next 5 public events as they arrive (/api/v1/streaming/public).
+
+#if __has_include("mastodonpp.hpp")
+#    include "mastodonpp.hpp" // We're building mastodonpp.
+#else
+#    include <mastodonpp/mastodonpp.hpp> // We're building outside mastodonpp.
+#endif
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace masto = mastodonpp;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+int main(int argc, char *argv[])
+{
+    const vector<string_view> args(argv, argv + argc);
+    if (args.size() <= 1)
+    {
+        cerr << "Usage: " << args[0] << " <instance hostname>\n";
+        return 1;
+    }
+
+    try
+    {
+        // Initialize an Instance.
+        masto::Instance instance{args[1], {}};
+
+        // Initialize a Connection.
+        masto::Connection connection{instance};
+
+        // Stream public events. The function is called with every event as
+        // soon as it arrives. stream() returns when the stream is cancelled.
+        auto counter{0};
+        auto answer{connection.stream(
+            masto::API::v1::streaming_public, {},
+            [&](masto::event_type &&event)
+            {
+                // Print type of event and the beginning of the data.
+                cout << event.type << ": " << event.data.substr(0, 70) << " …"
+                     << endl;
+                if (++counter == 5)
+                {
+                    connection.cancel_stream();
+                }
+
+                // Returning false would pause the stream.
+                return true;
+            })};
+
+        if (!answer)
+        {
+            if (answer.curl_error_code == 0)
+            {
+                // If it is no libcurl error, it must be an HTTP error.
+                cerr << "HTTP status: " << answer.http_status << endl;
+            }
+            else
+            {
+                // Network errors like “Couldn't resolve host.”.
+                cerr << "libcurl error " << to_string(answer.curl_error_code)
+                     << ": " << answer.error_message << endl;
+            }
+        }
+    }
+    catch (const masto::CURLException &e)
+    {
+        // Only libcurl errors that are not network errors will be thrown.
+        // There went probably something wrong with the initialization.
+        cerr << e.what() << endl;
+    }
+
+    return 0;
+}
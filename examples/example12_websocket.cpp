@@ -0,0 +1,105 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ *  SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ *  OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ *  CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Print events of a hashtag and of the local timeline, received over one
+// WebSocket connection (/api/v1/streaming).
+
+#if __has_include("mastodonpp.hpp")
+#    include "mastodonpp.hpp" // We're building mastodonpp.
+#else
+#    include <mastodonpp/mastodonpp.hpp> // We're building outside mastodonpp.
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace masto = mastodonpp;
+using namespace std::chrono_literals;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+int main(int argc, char *argv[])
+{
+    const vector<string_view> args(argv, argv + argc);
+    if (args.size() <= 3)
+    {
+        cerr << "Usage: " << args[0]
+             << " <instance hostname> <access token> <hashtag>\n";
+        return 1;
+    }
+
+    try
+    {
+        // Initialize an Instance.
+        masto::Instance instance{args[1], args[2]};
+
+        // Initialize a WebSocketStream.
+        masto::WebSocketStream websocket{instance};
+
+        // Print type of event and the beginning of the data.
+        auto counter{0};
+        auto print_event{[&](masto::event_type &&event)
+                         {
+                             cout << event.type << ": "
+                                  << event.data.substr(0, 70) << " …" << endl;
+                             ++counter;
+
+                             // Returning false would unsubscribe.
+                             return true;
+                         }};
+
+        // Both streams share one connection.
+        websocket.subscribe("hashtag", args[3], print_event);
+        websocket.subscribe("public:local", {}, print_event);
+
+        auto answer{websocket.connect()};
+        if (!websocket.is_connected())
+        {
+            if (answer.curl_error_code == 0)
+            {
+                // If it is no libcurl error, it must be an HTTP error.
+                cerr << "HTTP status: " << answer.http_status << endl;
+            }
+            else
+            {
+                // Network errors like “Couldn't resolve host.”.
+                cerr << "libcurl error " << to_string(answer.curl_error_code)
+                     << ": " << answer.error_message << endl;
+            }
+            return 1;
+        }
+
+        // Wait for 10 events. poll() calls the callbacks.
+        while (websocket.is_connected() && counter < 10)
+        {
+            websocket.poll(10s);
+        }
+    }
+    catch (const masto::CURLException &e)
+    {
+        // Only libcurl errors that are not network errors will be thrown.
+        // There went probably something wrong with the initialization.
+        cerr << e.what() << endl;
+    }
+
+    return 0;
+}
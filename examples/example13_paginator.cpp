@@ -0,0 +1,100 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ *  SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ *  OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ *  CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Print the addresses of the accounts that follow an account. The next page is
+// fetched while the current one is printed.
+
+#if __has_include("mastodonpp.hpp")
+#    include "mastodonpp.hpp" // We're building mastodonpp.
+#else
+#    include <mastodonpp/mastodonpp.hpp> // We're building outside mastodonpp.
+#endif
+
+#include <iostream>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace masto = mastodonpp;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::regex;
+using std::sregex_iterator;
+using std::string_view;
+using std::to_string;
+using std::vector;
+
+int main(int argc, char *argv[])
+{
+    const vector<string_view> args(argv, argv + argc);
+    if (args.size() <= 2)
+    {
+        cerr << "Usage: " << args[0] << " <instance hostname> <account ID>\n";
+        return 1;
+    }
+
+    try
+    {
+        // Initialize an Instance.
+        masto::Instance instance{args[1], {}};
+
+        // Initialize a Paginator. It requests the first page immediately and
+        // keeps up to 2 pages ready. Stop after 10 pages.
+        size_t pages{0};
+        masto::Paginator followers{instance,
+                                   masto::API::v1::accounts_id_followers,
+                                   {{"id", args[2]}, {"limit", "80"}},
+                                   2,
+                                   [&pages](const masto::answer_type &)
+                                   { return ++pages == 10; }};
+
+        // Iterate over the pages.
+        const regex re_id{R"("acct":"([^"]+))"};
+        for (const auto &page : followers)
+        {
+            if (!page)
+            {
+                if (page.curl_error_code == 0)
+                {
+                    // If it is no libcurl error, it must be an HTTP error.
+                    cerr << "HTTP status: " << page.http_status << endl;
+                }
+                else
+                {
+                    // Network errors like “Couldn't resolve host.”.
+                    cerr << "libcurl error " << to_string(page.curl_error_code)
+                         << ": " << page.error_message << endl;
+                }
+                break;
+            }
+
+            for (sregex_iterator it{page.body.begin(), page.body.end(), re_id};
+                 it != sregex_iterator{}; ++it)
+            {
+                cout << (*it)[1] << '\n';
+            }
+        }
+    }
+    catch (const masto::CURLException &e)
+    {
+        // Only libcurl errors that are not network errors will be thrown.
+        // There went probably something wrong with the initialization.
+        cerr << e.what() << endl;
+    }
+
+    return 0;
+}
@@ -20,8 +20,12 @@
 #include "api.hpp"
 #include "curl_wrapper.hpp"
 #include "instance.hpp"
+#include "response_cache.hpp"
+#include "retry.hpp"
 #include "types.hpp"
+#include "uri_template.hpp"
 
+#include <memory>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -30,6 +34,7 @@
 namespace mastodonpp
 {
 
+using std::shared_ptr;
 using std::string;
 using std::string_view;
 using std::variant;
@@ -38,32 +43,14 @@ using std::vector;
 /*!
  *  @brief  An endpoint. Either API::endpoint_type or `std::string_view`.
  *
- *  @since  0.1.0
- */
-using endpoint_variant = variant<API::endpoint_type, string_view>;
-
-/*!
- *  @brief  A stream event.
+ *  The placeholders of `std::string_view` endpoints, like `<ID>`, are found
+ *  at runtime. If a `<` is not closed or if there are more than
+ *  endpoint_path::max_placeholders placeholders, a CURLException with
+ *  `CURLE_URL_MALFORMAT` is thrown.
  *
  *  @since  0.1.0
- *
- *  @headerfile connection.hpp mastodonpp/connection.hpp
  */
-struct event_type
-{
-    /*!
-     *  @brief  The type of the event.
-     *
-     *  Can be: “update”, “notification”, “delete” or “filters_changed”. For
-     *  more information consult [the Mastodon documentation]
-     *  (https://docs.joinmastodon.org/methods/timelines/streaming/
-     *  #event-types-a-idevent-typesa).
-     */
-    string type;
-
-    //! The payload.
-    string data;
-};
+using endpoint_variant = variant<API::endpoint_type, string_view>;
 
 /*!
  *  @brief  Represents a connection to an instance. Used for requests.
@@ -86,18 +73,36 @@ public:
      *  @since  0.1.0
      */
     explicit Connection(const Instance &instance)
-        : _instance{instance}
+        : CURLWrapper{instance.get_hostname()}
+        , _instance{instance}
         , _baseuri{instance.get_baseuri()}
+        , _rate_limiter{instance.get_rate_limiter()}
+        , _single_flight{instance.get_single_flight()}
     {
         _instance.copy_connection_properties(*this);
     }
 
     /*!
-     *  @brief  Copy constructor. A new CURLWrapper is constructed.
+     *  @brief  Copy constructor. A new CURLWrapper is constructed, with a
+     *          handle from the same pool.
+     *
+     *  The timeout set with set_timeout() is applied to the new handle.
      *
      *  @since  0.5.2
      */
-    Connection(const Connection &other) = default;
+    Connection(const Connection &other)
+        : CURLWrapper{other}
+        , _instance{other._instance}
+        , _baseuri{other._baseuri}
+        , _rate_limiter{other._rate_limiter}
+        , _retry_policy{other._retry_policy}
+        , _retry_budget{other._retry_budget}
+        , _timeout{other._timeout}
+        , _response_cache{other._response_cache}
+        , _single_flight{other._single_flight}
+    {
+        limit_timeout(milliseconds{0});
+    }
 
     //! Move constructor
     Connection(Connection &&other) noexcept = delete;
@@ -126,6 +131,7 @@ public:
      *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
      *  @param parameters A map of parameters.
      *
+     *  @see    endpoint_variant for malformed endpoints.
      *
      *  @since  0.1.0
      */
@@ -142,6 +148,8 @@ public:
      *
      *  @param endpoint Endpoint as API::endpoint_type or `std::string_view`.
      *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
      *  @since  0.1.0
      */
     [[nodiscard]] inline answer_type get(const endpoint_variant &endpoint)
@@ -166,6 +174,7 @@ public:
      *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
      *  @param parameters A map of parameters.
      *
+     *  @see    endpoint_variant for malformed endpoints.
      *
      *  @since  0.1.0
      */
@@ -177,6 +186,8 @@ public:
      *
      *  @param endpoint Endpoint as API::endpoint_type or `std::string_view`.
      *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
      *  @since  0.1.0
      */
     [[nodiscard]] inline answer_type post(const endpoint_variant &endpoint)
@@ -190,6 +201,7 @@ public:
      *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
      *  @param parameters A map of parameters.
      *
+     *  @see    endpoint_variant for malformed endpoints.
      *
      *  @since  0.2.0
      */
@@ -201,6 +213,8 @@ public:
      *
      *  @param endpoint Endpoint as API::endpoint_type or `std::string_view`.
      *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
      *  @since  0.2.0
      */
     [[nodiscard]] inline answer_type patch(const endpoint_variant &endpoint)
@@ -214,6 +228,7 @@ public:
      *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
      *  @param parameters A map of parameters.
      *
+     *  @see    endpoint_variant for malformed endpoints.
      *
      *  @since  0.2.0
      */
@@ -225,6 +240,8 @@ public:
      *
      *  @param endpoint Endpoint as API::endpoint_type or `std::string_view`.
      *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
      *  @since  0.2.0
      */
     [[nodiscard]] inline answer_type put(const endpoint_variant &endpoint)
@@ -238,6 +255,7 @@ public:
      *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
      *  @param parameters A map of parameters.
      *
+     *  @see    endpoint_variant for malformed endpoints.
      *
      *  @since  0.2.0
      */
@@ -249,6 +267,8 @@ public:
      *
      *  @param endpoint Endpoint as API::endpoint_type or `std::string_view`.
      *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
      *  @since  0.2.0
      */
     [[nodiscard]] inline answer_type del(const endpoint_variant &endpoint)
@@ -256,6 +276,43 @@ public:
         return del(endpoint, {});
     }
 
+    /*!
+     *  @brief  Make a streaming HTTP GET call and call a function with every
+     *          event.
+     *
+     *  The events are delivered as soon as they arrive, from the thread that
+     *  called this function. Blocks until the stream ends or is cancelled with
+     *  cancel_stream(). Return `false` from the callback or call
+     *  pause_stream() to stop reading from the network until resume_stream()
+     *  is called.
+     *
+     *  If the callback throws an exception, the stream is closed and the
+     *  exception is rethrown by this function.
+     *
+     *  Example:
+     *  @code
+     *  connection.stream(mastodonpp::API::v1::streaming_public, {},
+     *                    [](mastodonpp::event_type &&event)
+     *                    {
+     *                        std::cout << event.type << '\n';
+     *                        return true;
+     *                    });
+     *  @endcode
+     *
+     *  @param endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param parameters A map of parameters.
+     *  @param callback   Is called with every event.
+     *
+     *  @see    endpoint_variant for malformed endpoints.
+     *
+     *  @return The answer, without body.
+     *
+     *  @since  0.6.0
+     */
+    answer_type stream(const endpoint_variant &endpoint,
+                       const parametermap &parameters,
+                       event_callback callback);
+
     /*!
      *  @brief  Copy new stream contents and delete the “original”.
      *
@@ -272,6 +329,11 @@ public:
     /*!
      *  @brief  Get new stream events.
      *
+     *  Only complete events are returned, incomplete events are kept until
+     *  the rest arrives. After the first call, the stream is parsed as it
+     *  arrives and get_new_stream_contents() returns nothing for the rest of
+     *  the request.
+     *
      *  @since  0.1.0
      */
     vector<event_type> get_new_events();
@@ -282,12 +344,159 @@ public:
         CURLWrapper::cancel_stream();
     }
 
+    //! @copydoc CURLWrapper::pause_stream
+    inline void pause_stream()
+    {
+        CURLWrapper::pause_stream();
+    }
+
+    //! @copydoc CURLWrapper::resume_stream
+    inline void resume_stream()
+    {
+        CURLWrapper::resume_stream();
+    }
+
+    //! @copydoc CURLWrapper::set_progress_callback
+    inline void set_progress_callback(progress_callback callback)
+    {
+        CURLWrapper::set_progress_callback(std::move(callback));
+    }
+
+    /*!
+     *  @brief  Abort transfers after @a timeout. 0 means never, which is the
+     *          default.
+     *
+     *  Use this instead of `CURLOPT_TIMEOUT_MS`. With a retry_policy that has
+     *  a deadline, every attempt is aborted at the deadline or after
+     *  @a timeout, whatever comes first.
+     *
+     *  @since  0.6.0
+     */
+    void set_timeout(milliseconds timeout);
+
+    /*!
+     *  @brief  Repeat requests that failed for reasons that may go away.
+     *
+     *  Applies to get(), post(), patch(), put() and del(), not to streams.
+     *  Between attempts, the calling thread sleeps. The answer of the last
+     *  attempt is returned. Copies of this Connection share the RetryBudget.
+     *  Disabled by default.
+     *
+     *  @param  policy The retry_policy. Set retry_policy::max_attempts to 1
+     *                 to disable retries.
+     *
+     *  @since  0.6.0
+     */
+    void set_retry_policy(const retry_policy &policy);
+
+    /*!
+     *  @brief  Repeat requests that failed, with a RetryBudget that is
+     *          shared with other Connection%s.
+     *
+     *  Like set_retry_policy(const retry_policy &), but the retries of all
+     *  Connection%s using @a budget are limited together.
+     *
+     *  @param  policy The retry_policy.
+     *  @param  budget The RetryBudget. If it is `nullptr`, a new one is made.
+     *
+     *  @since  0.6.0
+     */
+    void set_retry_policy(const retry_policy &policy,
+                          shared_ptr<RetryBudget> budget);
+
+    /*!
+     *  @brief  Returns the statistics of the RetryBudget.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] retry_metrics get_retry_metrics() const;
+
+    /*!
+     *  @brief  Answer `GET` requests from a cache, if possible.
+     *
+     *  Stored answers are returned without asking the server while they are
+     *  fresh, and revalidated with `If-None-Match` and `If-Modified-Since`
+     *  after that. Answers from the cache do not count against the rate
+     *  limit. Streams are not cached. Pass `nullptr` to disable the cache,
+     *  which is the default.
+     *
+     *  Example:
+     *  @code
+     *  auto cache{std::make_shared<mastodonpp::MemoryCache>()};
+     *  connection.set_response_cache(cache);
+     *  auto answer{connection.get(mastodonpp::API::v1::custom_emojis)};
+     *  std::cout << cache->get_metrics().hits << '\n';
+     *  @endcode
+     *
+     *  @param  cache A MemoryCache, DiskCache or your own ResponseCache.
+     *
+     *  @since  0.6.0
+     */
+    inline void set_response_cache(shared_ptr<ResponseCache> cache) noexcept
+    {
+        _response_cache = std::move(cache);
+    }
+
+protected:
+    /*!
+     *  @brief  Returns the URI template of the endpoint.
+     *
+     *  The placeholders of API endpoints are known at compile time, those of
+     *  other endpoints are found now.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] URITemplate
+    endpoint_to_template(const endpoint_variant &endpoint) const;
+
+    /*!
+     *  @brief  Abort the next transfer after the timeout set with
+     *          set_timeout() or after @a time_left, whatever is shorter.
+     *
+     *  @param  time_left The time until the deadline, 0 if there is none.
+     *
+     *  @since  0.6.0
+     */
+    void limit_timeout(milliseconds time_left);
+
 private:
     const Instance &_instance;
     const string_view _baseuri;
+    shared_ptr<RateLimiter> _rate_limiter;
+    retry_policy _retry_policy;
+    shared_ptr<RetryBudget> _retry_budget;
+    milliseconds _timeout{0};
+    shared_ptr<ResponseCache> _response_cache;
+    shared_ptr<SingleFlight> _single_flight;
+
+    /*!
+     *  @brief  Make a request, or wait for an identical one if request
+     *          coalescing is enabled.
+     *
+     *  @since  0.6.0
+     */
+    answer_type request(const http_method &method,
+                        const endpoint_variant &endpoint,
+                        const parametermap &parameters);
+
+    /*!
+     *  @brief  Make a request, and repeat it according to the retry_policy.
+     *
+     *  @since  0.6.0
+     */
+    answer_type request_with_retries(const http_method &method,
+                                     const endpoint_variant &endpoint,
+                                     const parametermap &parameters);
 
-    [[nodiscard]] string
-    endpoint_to_uri(const endpoint_variant &endpoint) const;
+    /*!
+     *  @brief  Make one attempt, after looking into the ResponseCache and
+     *          waiting for the RateLimiter, if any.
+     *
+     *  @since  0.6.0
+     */
+    answer_type attempt(const http_method &method,
+                        const endpoint_variant &endpoint,
+                        const parametermap &parameters);
 };
 
 } // namespace mastodonpp
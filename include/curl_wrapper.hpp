@@ -18,18 +18,30 @@
 #define MASTODONPP_CURL_WRAPPER_HPP
 
 #include "curl/curl.h"
+#include "json.hpp"
+#include "sse_parser.hpp"
 #include "types.hpp"
+#include "uri_template.hpp"
 
+#include <atomic>
+#include <exception>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace mastodonpp
 {
 
+using std::atomic;
+using std::exception_ptr;
 using std::mutex;
+using std::shared_ptr;
 using std::string;
 using std::string_view;
+using std::unique_ptr;
+using std::vector;
 
 /*!
  *  @brief  The HTTP method.
@@ -45,11 +57,19 @@ enum class http_method
     DELETE // NOLINT(readability-identifier-naming)
 };
 
+class HandlePool;
+template <typename T> class SPSCQueue;
+
 /*!
  *  @brief  Handles the details of network connections.
  *
  *  You don't need to use this.
  *
+ *  CURL easy handles are borrowed from a pool per host and returned when the
+ *  CURLWrapper is destroyed. All handles of a host share the DNS cache and
+ *  the TLS session cache. The handles keep their connections open while they
+ *  are in the pool, so that a new CURLWrapper can reuse them.
+ *
  *  @since  0.1.0
  *
  *  @headerfile curl_wrapper.hpp mastodonpp/curl_wrapper.hpp
@@ -70,17 +90,27 @@ public:
     CURLWrapper();
 
     /*!
-     *  @brief  Copy constructor. Does the same as the Constructor.
+     *  @brief  Initializes curl and sets up connection, using the pool of the
+     *          host.
+     *
+     *  @param  hostname The hostname of the instance.
+     *
+     *  @since  0.6.0
+     */
+    explicit CURLWrapper(string_view hostname);
+
+    /*!
+     *  @brief  Copy constructor. Borrows a new handle from the same pool.
      *
      *  @since  0.5.2
      */
-    CURLWrapper(const CURLWrapper &);
+    CURLWrapper(const CURLWrapper &other);
 
     //! Move constructor
     CURLWrapper(CURLWrapper &&other) noexcept = delete;
 
     /*!
-     *  @brief  Cleans up curl and connection.
+     *  @brief  Returns the handle to the pool and cleans up curl.
      *
      *  May call `curl_global_cleanup`, which is not thread-safe. For more
      *  information consult [curl_global_cleanup(3)]
@@ -163,6 +193,42 @@ public:
                                      string_view access_token,
                                      string_view cainfo, string_view useragent);
 
+    /*!
+     *  @brief  Hand over a buffer for the body of the next answer.
+     *
+     *  The body of the answer is moved out of the buffer libcurl writes into,
+     *  so the buffer has to grow again with the next request. Pass a string
+     *  with reserved capacity, or the body of an answer you don't need anymore,
+     *  to avoid that. The contents of the string are discarded.
+     *
+     *  Example:
+     *  @code
+     *  auto answer{connection.get(mastodonpp::API::v1::timelines_public)};
+     *  process(answer.body);
+     *  connection.set_body_buffer(std::move(answer.body));
+     *  @endcode
+     *
+     *  @param  buffer The buffer.
+     *
+     *  @since  0.6.0
+     */
+    void set_body_buffer(string buffer);
+
+    /*!
+     *  @brief  Index JSON bodies while they are received.
+     *
+     *  The index is stored in answer_type::json_index and can be accessed
+     *  through answer_type::json(). Parsing happens in the chunks libcurl
+     *  hands over, so no second pass over the body is needed. Disabled by
+     *  default. Has no effect on streams.
+     *
+     *  @since  0.6.0
+     */
+    inline void set_json_indexing(const bool enable) noexcept
+    {
+        _json_indexing = enable;
+    }
+
 protected:
     /*!
      *  @brief  Mutex for #get_buffer a.k.a. _curl_buffer_body.
@@ -178,7 +244,7 @@ protected:
      *  @brief  Make a HTTP request.
      *
      *  @param  method     The HTTP method.
-     *  @param  uri        The full URI.
+     *  @param  uri        The full URI. It has no placeholders.
      *  @param  parameters A map of parameters.
      *
      *  @since  0.1.0
@@ -187,6 +253,82 @@ protected:
                                            string uri,
                                            const parametermap &parameters);
 
+    /*!
+     *  @brief  Make a HTTP request.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  uri        The URI, with placeholders.
+     *  @param  parameters A map of parameters. Parameters that are bound to
+     *                     placeholders are not sent otherwise.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type make_request(const http_method &method,
+                                           const URITemplate &uri,
+                                           const parametermap &parameters);
+
+    /*!
+     *  @brief  Set up the connection for a HTTP request, without performing
+     *          it.
+     *
+     *  Used by make_request() and by the Dispatcher, which performs the request
+     *  with libcurl's multi interface.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  uri        The URI, with placeholders.
+     *  @param  parameters A map of parameters.
+     *
+     *  @since  0.6.0
+     */
+    void prepare_request(const http_method &method, const URITemplate &uri,
+                         const parametermap &parameters);
+
+    /*!
+     *  @brief  Perform a request that was set up with prepare_request().
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type perform_request();
+
+    /*!
+     *  @brief  Returns the URI of the request set up by prepare_request().
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline const string &get_uri() const noexcept
+    {
+        return _uri;
+    }
+
+    /*!
+     *  @brief  Send additional headers with the request set up by
+     *          prepare_request().
+     *
+     *  @param  headers Complete header lines, like `"If-None-Match: abc"`.
+     *
+     *  @since  0.6.0
+     */
+    void set_request_headers(const vector<string> &headers);
+
+    /*!
+     *  @brief  Build the answer after a request has been performed.
+     *
+     *  @param  code The result of the transfer.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type finish_request(CURLcode code);
+
+    /*!
+     *  @brief  Clear the buffers, so that a prepared request can be performed
+     *          again.
+     *
+     *  Used by prepare_request() and by the Dispatcher, to retry requests.
+     *
+     *  @since  0.6.0
+     */
+    void reset_buffers();
+
     /*!
      *  @brief  Returns a reference to the buffer libcurl writes into.
      *
@@ -197,6 +339,21 @@ protected:
         return _curl_buffer_body;
     }
 
+    /*!
+     *  @brief  Returns the stream events that arrived since the last call.
+     *
+     *  The first call during a request parses the contents of the buffer and
+     *  clears it. From then on, data is parsed as it arrives and does not end
+     *  up in the buffer anymore. The events are handed over through a
+     *  lock-free queue; neither this function nor libcurl wait for each other.
+     *  If the queue is full, the transfer is paused until there is room again.
+     *
+     *  Events of a previous request that were not taken yet are returned too.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] vector<event_type> take_stream_events();
+
     /*!
      *  @brief  Cancel the stream.
      *
@@ -211,6 +368,57 @@ protected:
         _stream_cancelled = true;
     }
 
+    /*!
+     *  @brief  Set a function that is called with every stream event, as it
+     *          arrives.
+     *
+     *  The events are parsed and delivered from the write callback of libcurl,
+     *  nothing is written into the buffer. Pass an empty function to switch
+     *  back to buffering.
+     *
+     *  @since  0.6.0
+     */
+    void set_event_callback(event_callback callback);
+
+    /*!
+     *  @brief  Set a function that is called with the progress of requests.
+     *
+     *  It is called from the thread that performs the request. Pass an empty
+     *  function to remove it.
+     *
+     *  @since  0.6.0
+     */
+    inline void set_progress_callback(progress_callback callback)
+    {
+        _progress_callback = std::move(callback);
+    }
+
+    /*!
+     *  @brief  Pause the stream.
+     *
+     *  No more events are delivered and no more data is read from the socket
+     *  until resume_stream() is called. The server will stop sending once the
+     *  buffers of the operating system are full.
+     *
+     *  @since  0.6.0
+     */
+    inline void pause_stream()
+    {
+        _stream_paused = true;
+    }
+
+    /*!
+     *  @brief  Resume a paused stream.
+     *
+     *  The stream will be resumed, usually whithin a second.
+     *
+     *  @since  0.6.0
+     */
+    inline void resume_stream()
+    {
+        _stream_paused = false;
+    }
+
     /*!
      *  @brief  Set the proxy to use.
      *
@@ -245,18 +453,38 @@ protected:
     virtual void set_useragent(string_view useragent);
 
 private:
+    shared_ptr<HandlePool> _pool;
     CURL *_connection{nullptr};
     char _curl_buffer_error[CURL_ERROR_SIZE]{'\0'};
     string _curl_buffer_headers;
     string _curl_buffer_body;
-    bool _stream_cancelled{false};
+    bool _json_indexing{false};
+    JSONIndexer _json_indexer;
+    string _uri;
+    //! The urlencoded body of the request. Reused, to keep the memory.
+    string _request_body;
+    curl_slist *_request_headers{nullptr};
+    curl_mime *_request_form{nullptr};
+    atomic<bool> _stream_cancelled{false};
+    SSEParser _sse_parser;
+    vector<event_type> _stream_events;
+    atomic<bool> _parse_stream{false};
+    unique_ptr<SPSCQueue<event_type>> _event_queue;
+    event_callback _event_callback;
+    progress_callback _progress_callback;
+    size_t _stream_events_delivered{0};
+    atomic<bool> _stream_paused{false};
+    bool _curl_paused{false};
+    exception_ptr _callback_exception;
 
     /*!
      *  @brief  Initializes curl and sets up connection.
      *
+     *  @param  hostname The key of the handle pool.
+     *
      *  @since  0.5.2
      */
-    void init();
+    void init(string_view hostname);
 
     /*!
      *  @brief  libcurl write callback function.
@@ -265,6 +493,12 @@ private:
      */
     size_t writer_body(char *data, size_t size, size_t nmemb);
 
+    //! Stop sending the headers set with set_request_headers().
+    void clear_request_headers();
+
+    //! Free the multipart form of the last request.
+    void clear_request_form();
+
     /*!
      *  @brief  Wrapper for curl, because it can only call static member
      *          functions.
@@ -289,23 +523,33 @@ private:
         return static_cast<CURLWrapper *>(f)->writer_header(data, sz, nmemb);
     }
 
+    /*!
+     *  @brief  Call the event callback with the events that are not delivered
+     *          yet, or move them into the event queue if there is no callback.
+     *
+     *  @return false if the stream was paused or the queue is full.
+     *
+     *  @since  0.6.0
+     */
+    bool deliver_stream_events();
+
     /*!
      *  @brief  libcurl transfer info function.
      *
-     *  Used to cancel streams.
+     *  Used to cancel and resume streams and to report the progress.
      *
      *  @since  0.1.0
      */
-    int progress(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
-                 curl_off_t ultotal, curl_off_t ulnow) const;
+    int progress(curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal,
+                 curl_off_t ulnow);
 
     //! @copydoc writer_body_wrapper
-    static inline int progress_wrapper(void *f, void *clientp,
-                                       curl_off_t dltotal, curl_off_t dlnow,
-                                       curl_off_t ultotal, curl_off_t ulnow)
+    static inline int progress_wrapper(void *f, curl_off_t dltotal,
+                                       curl_off_t dlnow, curl_off_t ultotal,
+                                       curl_off_t ulnow)
     {
-        return static_cast<CURLWrapper *>(f)->progress(clientp, dltotal, dlnow,
-                                                       ultotal, ulnow);
+        return static_cast<CURLWrapper *>(f)->progress(dltotal, dlnow, ultotal,
+                                                       ulnow);
     }
 
     /*!
@@ -315,28 +559,18 @@ private:
      */
     void setup_curl();
 
-    /*!
-     *  @brief  Replace parameter in URI.
-     *
-     *  @param  uri       Reference to the URI.
-     *  @param  parameter The parameter.
-     *
-     *  @return true if parameter was replaced.
-     *
-     *  @since  0.1.0
-     */
-    static bool replace_parameter_in_uri(string &uri,
-                                         const parameterpair &parameter);
-
     /*!
      *  @brief  Add parameters to URI.
      *
+     *  Parameters that are bound to placeholders are skipped.
+     *
      *  @param  uri        Reference to the URI.
+     *  @param  templ      The template the URI was rendered from.
      *  @param  parameters The parametermap.
      *
      *  @since  0.1.0
      */
-    static void add_parameters_to_uri(string &uri,
+    static void add_parameters_to_uri(string &uri, const URITemplate &templ,
                                       const parametermap &parameters);
 
     /*!
@@ -351,22 +585,67 @@ private:
     static void add_mime_part(curl_mime *mime, string_view name,
                               string_view data);
 
+    /*!
+     *  @brief  Add an attachment as `*curl_mimepart` to `*curl_mime`.
+     *
+     *  The data is read by libcurl while the request is sent.
+     *
+     *  @param  mime Initialized `*curl_mime`.
+     *  @param  name Name of the field.
+     *  @param  file The attachment.
+     *
+     *  @since  0.6.0
+     */
+    static void add_mime_part(curl_mime *mime, string_view name,
+                              const attachment &file);
+
     /*!
      *  @brief  Convert parametermap to `*curl_mime`.
      *
      *  For more information consult [curl_mime_init(3)]
-     *  (https://curl.haxx.se/libcurl/c/curl_mime_init.html). Calls
-     *  replace_parameter_in_uri().
+     *  (https://curl.haxx.se/libcurl/c/curl_mime_init.html). Parameters
+     *  that are bound to placeholders are skipped.
      *
-     *  @param  uri        Reference to the URI.
+     *  @param  templ      The template the URI was rendered from.
      *  @param  parameters The parametermap.
      *
-     *  @return `*curl_mime`.
+     *  @return `*curl_mime`. The caller has to free it with curl_mime_free().
      *
      *  @since  0.1.0
      */
-    curl_mime *parameters_to_curl_mime(string &uri,
+    curl_mime *parameters_to_curl_mime(const URITemplate &templ,
                                        const parametermap &parameters);
+
+    /*!
+     *  @brief  Encode parametermap as `application/x-www-form-urlencoded`.
+     *
+     *  Parameters that are bound to placeholders are skipped. Arrays are
+     *  encoded as `name[]=value` pairs.
+     *
+     *  @param  templ      The template the URI was rendered from.
+     *  @param  parameters The parametermap.
+     *  @param  out        The encoded form is appended to this.
+     *
+     *  @since  0.6.0
+     */
+    static void parameters_to_urlencoded(const URITemplate &templ,
+                                         const parametermap &parameters,
+                                         string &out);
+
+    /*!
+     *  @brief  Set the body of the request.
+     *
+     *  Parameters with files are sent as `multipart/form-data`, all others as
+     *  `application/x-www-form-urlencoded`, which is smaller and faster to
+     *  build. Without parameters, an empty body is sent.
+     *
+     *  @param  templ      The template the URI was rendered from.
+     *  @param  parameters The parametermap.
+     *
+     *  @since  0.6.0
+     */
+    void set_request_body(const URITemplate &templ,
+                          const parametermap &parameters);
 };
 
 } // namespace mastodonpp
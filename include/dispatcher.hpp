@@ -0,0 +1,331 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_DISPATCHER_HPP
+#define MASTODONPP_DISPATCHER_HPP
+
+#include "connection.hpp"
+#include "curl_wrapper.hpp"
+#include "instance.hpp"
+#include "retry.hpp"
+#include "types.hpp"
+
+#include <curl/curl.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::function;
+using std::future;
+using std::mutex;
+using std::thread;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+using std::chrono::milliseconds;
+
+/*!
+ *  @brief  Function that is called with the answer of an asynchronous request.
+ *
+ *  @since  0.6.0
+ */
+using answer_callback = function<void(answer_type)>;
+
+/*!
+ *  @brief  Makes many requests concurrently, on one thread.
+ *
+ *  The requests are multiplexed with [libcurl's multi interface]
+ *  (https://curl.haxx.se/libcurl/c/libcurl-multi.html) on a background
+ *  thread, which is started by the constructor and stopped by the destructor.
+ *  Requests to the same host share connections and, if the server supports
+ *  it, are sent over the same HTTP/2 connection.
+ *
+ *  All properties of the Instance (proxy, access token, …) are used for the
+ *  requests. The Instance has to outlive the Dispatcher.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::Dispatcher dispatcher{instance};
+ *  auto answer1{dispatcher.submit(mastodonpp::http_method::GET,
+ *                                 mastodonpp::API::v1::accounts_id,
+ *                                 {{"id", "1"}})};
+ *  auto answer2{dispatcher.submit(mastodonpp::http_method::GET,
+ *                                 mastodonpp::API::v1::accounts_id,
+ *                                 {{"id", "2"}})};
+ *  std::cout << answer1.get() << answer2.get();
+ *  @endcode
+ *
+ *  All member functions are thread-safe.
+ *
+ *  If rate limiting is enabled in the Instance, requests are queued until the
+ *  RateLimiter allows them, without blocking the other requests. The same goes
+ *  for requests that wait for a retry, see set_retry_policy().
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile dispatcher.hpp mastodonpp/dispatcher.hpp
+ */
+class Dispatcher
+{
+public:
+    /*!
+     *  @brief  Construct a new Dispatcher and start the event loop.
+     *
+     *  @param  instance An Instance with the access data.
+     *
+     *  @since  0.6.0
+     */
+    explicit Dispatcher(const Instance &instance);
+
+    //! Copy constructor
+    Dispatcher(const Dispatcher &other) = delete;
+
+    //! Move constructor
+    Dispatcher(Dispatcher &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Stops the event loop.
+     *
+     *  Requests that are still running are aborted. Their @link
+     *  answer_type::curl_error_code curl_error_code @endlink will be set to 42
+     *  (`CURLE_ABORTED_BY_CALLBACK`).
+     *
+     *  @since  0.6.0
+     */
+    ~Dispatcher() noexcept;
+
+    //! Copy assignment operator
+    Dispatcher &operator=(const Dispatcher &other) = delete;
+
+    //! Move assignment operator
+    Dispatcher &operator=(Dispatcher &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Queue a HTTP request.
+     *
+     *  The parameters are processed before this function returns, they do not
+     *  need to outlive the call.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *
+     *  @return A future that becomes ready when the request is finished.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] future<answer_type> submit(const http_method &method,
+                                             const endpoint_variant &endpoint,
+                                             const parametermap &parameters);
+
+    /*!
+     *  @brief  Queue a HTTP request and call a function with the answer.
+     *
+     *  The callback is called from the thread of the event loop. Do not block
+     *  in it, every other request waits until it returns.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *  @param  callback   Is called with the answer.
+     *
+     *  @since  0.6.0
+     */
+    void submit(const http_method &method, const endpoint_variant &endpoint,
+                const parametermap &parameters, answer_callback callback);
+
+    /*!
+     *  @brief  Queue a HTTP request, report its progress and call a function
+     *          with the answer.
+     *
+     *  Both callbacks are called from the thread of the event loop.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *  @param  callback   Is called with the answer.
+     *  @param  progress   Is called with the progress of the request.
+     *
+     *  @since  0.6.0
+     */
+    void submit(const http_method &method, const endpoint_variant &endpoint,
+                const parametermap &parameters, answer_callback callback,
+                progress_callback progress);
+
+    /*!
+     *  @brief  Queue a HTTP request that starts after @a delay.
+     *
+     *  Waiting does not block the event loop. Useful for polling.
+     *
+     *  @param  delay      The time to wait before the request starts.
+     *  @param  method     The HTTP method.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *  @param  callback   Is called with the answer.
+     *
+     *  @since  0.6.0
+     */
+    void submit_after(milliseconds delay, const http_method &method,
+                      const endpoint_variant &endpoint,
+                      const parametermap &parameters,
+                      answer_callback callback);
+
+    /*!
+     *  @brief  Limit the number of simultaneously open connections.
+     *
+     *  Requests above the limit are held back until a connection becomes
+     *  available. 0 means no limit, which is the default. For more
+     *  information consult [CURLMOPT_MAX_TOTAL_CONNECTIONS(3)]
+     *  (https://curl.haxx.se/libcurl/c/CURLMOPT_MAX_TOTAL_CONNECTIONS.html).
+     *
+     *  @since  0.6.0
+     */
+    void set_max_connections(long max); // NOLINT(google-runtime-int)
+
+    /*!
+     *  @brief  Abort transfers after @a timeout. 0 means never, which is the
+     *          default.
+     *
+     *  Applies to requests submitted afterwards. With a retry_policy that has
+     *  a deadline, every attempt is aborted at the deadline or after
+     *  @a timeout, whatever comes first.
+     *
+     *  @since  0.6.0
+     */
+    void set_timeout(milliseconds timeout);
+
+    /*!
+     *  @brief  Repeat requests that failed for reasons that may go away.
+     *
+     *  Applies to requests submitted afterwards. Waiting for the next attempt
+     *  does not block the event loop. The answer of the last attempt is
+     *  delivered. Disabled by default.
+     *
+     *  @param  policy The retry_policy. Set retry_policy::max_attempts to 1
+     *                 to disable retries.
+     *
+     *  @since  0.6.0
+     */
+    void set_retry_policy(const retry_policy &policy);
+
+    /*!
+     *  @brief  Returns the statistics of the RetryBudget.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] retry_metrics get_retry_metrics();
+
+    /*!
+     *  @brief  Returns the number of requests that are queued or running.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] size_t get_active_requests() const noexcept
+    {
+        return _active_requests;
+    }
+
+private:
+    class Transfer;
+    struct Request;
+
+    const Instance &_instance;
+    CURLM *_multi{nullptr};
+    mutex _mutex;
+    vector<unique_ptr<Request>> _pending;
+    vector<unique_ptr<Transfer>> _idle;
+    unordered_map<CURL *, unique_ptr<Request>> _running;
+    atomic<size_t> _active_requests{0};
+    atomic<long> _max_connections{-1}; // NOLINT(google-runtime-int)
+    atomic<bool> _stop{false};
+    shared_ptr<RateLimiter> _rate_limiter;
+    retry_policy _retry_policy;
+    shared_ptr<RetryBudget> _retry_budget;
+    milliseconds _timeout{0};
+    //! Requests waiting for the RateLimiter or for a retry. Only used by the
+    //! event loop.
+    vector<unique_ptr<Request>> _waiting;
+    thread _loop;
+
+    /*!
+     *  @brief  Prepare a request and queue it.
+     *
+     *  @since  0.6.0
+     */
+    void enqueue(const http_method &method, const endpoint_variant &endpoint,
+                 const parametermap &parameters, answer_callback callback,
+                 progress_callback progress, milliseconds delay);
+
+    /*!
+     *  @brief  The event loop.
+     *
+     *  @since  0.6.0
+     */
+    void run();
+
+    /*!
+     *  @brief  Add pending requests to the multi handle.
+     *
+     *  @return The time until the next request waiting for the RateLimiter
+     *          may start.
+     *
+     *  @since  0.6.0
+     */
+    milliseconds add_pending();
+
+    /*!
+     *  @brief  Remove finished transfers and call their callbacks.
+     *
+     *  @since  0.6.0
+     */
+    void process_finished();
+
+    /*!
+     *  @brief  Wake the event loop up.
+     *
+     *  @since  0.6.0
+     */
+    void wakeup();
+
+    /*!
+     *  @brief  Returns an idle transfer or creates a new one.
+     *
+     *  @since  0.6.0
+     */
+    unique_ptr<Transfer> get_transfer();
+
+    /*!
+     *  @brief  Puts a transfer back into the idle pool.
+     *
+     *  @since  0.6.0
+     */
+    void release_transfer(unique_ptr<Transfer> transfer);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_DISPATCHER_HPP
@@ -0,0 +1,425 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_ENTITIES_HPP
+#define MASTODONPP_ENTITIES_HPP
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace mastodonpp
+{
+
+using std::int64_t;
+using std::string;
+using std::string_view;
+
+/*!
+ *  @brief  Base of the views of entities.
+ *
+ *  Views do not copy anything. Every accessor looks up its value when it is
+ *  called. Accessors returning `string_view` return the value as it is in the
+ *  document, the others resolve escape sequences. Missing values are empty,
+ *  0 or false.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile entities.hpp mastodonpp/entities.hpp
+ */
+class EntityView
+{
+public:
+    //! Construct a view of an invalid value.
+    EntityView() = default;
+
+    /*!
+     *  @brief  Construct a view of an object.
+     *
+     *  @since  0.6.0
+     */
+    explicit EntityView(const JSONValue &json)
+        : _json{json}
+    {}
+
+    /*!
+     *  @brief  Returns true if the entity exists.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline bool valid() const noexcept
+    {
+        return _json.type() == json_type::object;
+    }
+
+    //! @copydoc valid
+    explicit operator bool() const noexcept
+    {
+        return valid();
+    }
+
+    /*!
+     *  @brief  Returns the ID.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline string_view id() const noexcept
+    {
+        return _json["id"].get_string_view();
+    }
+
+    /*!
+     *  @brief  Returns the object, for values without accessor.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline const JSONValue &get_json() const noexcept
+    {
+        return _json;
+    }
+
+protected:
+    //! The object.
+    JSONValue _json;
+};
+
+/*!
+ *  @brief  View of an [Account]
+ *          (https://docs.joinmastodon.org/entities/Account/).
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile entities.hpp mastodonpp/entities.hpp
+ */
+class AccountView : public EntityView
+{
+public:
+    using EntityView::EntityView;
+
+    //! The username, without the domain.
+    [[nodiscard]] inline string_view username() const noexcept
+    {
+        return _json["username"].get_string_view();
+    }
+
+    //! The username, with the domain for remote accounts.
+    [[nodiscard]] inline string_view acct() const noexcept
+    {
+        return _json["acct"].get_string_view();
+    }
+
+    //! The display name.
+    [[nodiscard]] inline string display_name() const
+    {
+        return _json["display_name"].get_string();
+    }
+
+    //! The profile description, as HTML.
+    [[nodiscard]] inline string note() const
+    {
+        return _json["note"].get_string();
+    }
+
+    //! The URL of the profile page.
+    [[nodiscard]] inline string_view url() const noexcept
+    {
+        return _json["url"].get_string_view();
+    }
+
+    //! The URL of the avatar.
+    [[nodiscard]] inline string_view avatar() const noexcept
+    {
+        return _json["avatar"].get_string_view();
+    }
+
+    //! The URL of the header image.
+    [[nodiscard]] inline string_view header() const noexcept
+    {
+        return _json["header"].get_string_view();
+    }
+
+    //! When the account was created, as ISO 8601 datetime.
+    [[nodiscard]] inline string_view created_at() const noexcept
+    {
+        return _json["created_at"].get_string_view();
+    }
+
+    //! True if follow requests have to be approved.
+    [[nodiscard]] inline bool locked() const noexcept
+    {
+        return _json["locked"].get_bool();
+    }
+
+    //! True if the account is automated.
+    [[nodiscard]] inline bool bot() const noexcept
+    {
+        return _json["bot"].get_bool();
+    }
+
+    //! The number of followers.
+    [[nodiscard]] inline int64_t followers_count() const noexcept
+    {
+        return _json["followers_count"].get_int();
+    }
+
+    //! The number of accounts followed.
+    [[nodiscard]] inline int64_t following_count() const noexcept
+    {
+        return _json["following_count"].get_int();
+    }
+
+    //! The number of statuses.
+    [[nodiscard]] inline int64_t statuses_count() const noexcept
+    {
+        return _json["statuses_count"].get_int();
+    }
+};
+
+/*!
+ *  @brief  View of a [Status]
+ *          (https://docs.joinmastodon.org/entities/Status/).
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile entities.hpp mastodonpp/entities.hpp
+ */
+class StatusView : public EntityView
+{
+public:
+    using EntityView::EntityView;
+
+    //! The URI for federation.
+    [[nodiscard]] inline string_view uri() const noexcept
+    {
+        return _json["uri"].get_string_view();
+    }
+
+    //! The URL of the HTML representation.
+    [[nodiscard]] inline string_view url() const noexcept
+    {
+        return _json["url"].get_string_view();
+    }
+
+    //! When the status was created, as ISO 8601 datetime.
+    [[nodiscard]] inline string_view created_at() const noexcept
+    {
+        return _json["created_at"].get_string_view();
+    }
+
+    //! The content, as HTML.
+    [[nodiscard]] inline string content() const
+    {
+        return _json["content"].get_string();
+    }
+
+    //! The content warning.
+    [[nodiscard]] inline string spoiler_text() const
+    {
+        return _json["spoiler_text"].get_string();
+    }
+
+    //! “public”, “unlisted”, “private” or “direct”.
+    [[nodiscard]] inline string_view visibility() const noexcept
+    {
+        return _json["visibility"].get_string_view();
+    }
+
+    //! The language, as ISO 639 code.
+    [[nodiscard]] inline string_view language() const noexcept
+    {
+        return _json["language"].get_string_view();
+    }
+
+    //! True if the attachments are marked as sensitive.
+    [[nodiscard]] inline bool sensitive() const noexcept
+    {
+        return _json["sensitive"].get_bool();
+    }
+
+    //! The ID of the status this is a reply to.
+    [[nodiscard]] inline string_view in_reply_to_id() const noexcept
+    {
+        return _json["in_reply_to_id"].get_string_view();
+    }
+
+    //! The ID of the account this is a reply to.
+    [[nodiscard]] inline string_view in_reply_to_account_id() const noexcept
+    {
+        return _json["in_reply_to_account_id"].get_string_view();
+    }
+
+    //! The number of replies.
+    [[nodiscard]] inline int64_t replies_count() const noexcept
+    {
+        return _json["replies_count"].get_int();
+    }
+
+    //! The number of boosts.
+    [[nodiscard]] inline int64_t reblogs_count() const noexcept
+    {
+        return _json["reblogs_count"].get_int();
+    }
+
+    //! The number of favourites.
+    [[nodiscard]] inline int64_t favourites_count() const noexcept
+    {
+        return _json["favourites_count"].get_int();
+    }
+
+    //! The account that posted the status.
+    [[nodiscard]] inline AccountView account() const noexcept
+    {
+        return AccountView{_json["account"]};
+    }
+
+    //! The boosted status. Invalid if this is no boost.
+    [[nodiscard]] inline StatusView reblog() const noexcept
+    {
+        return StatusView{_json["reblog"]};
+    }
+
+    //! The array of media attachments.
+    [[nodiscard]] inline JSONValue media_attachments() const noexcept
+    {
+        return _json["media_attachments"];
+    }
+};
+
+/*!
+ *  @brief  View of a [Notification]
+ *          (https://docs.joinmastodon.org/entities/Notification/).
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile entities.hpp mastodonpp/entities.hpp
+ */
+class NotificationView : public EntityView
+{
+public:
+    using EntityView::EntityView;
+
+    //! The type, for example “mention”, “reblog” or “follow”.
+    [[nodiscard]] inline string_view type() const noexcept
+    {
+        return _json["type"].get_string_view();
+    }
+
+    //! When the notification was created, as ISO 8601 datetime.
+    [[nodiscard]] inline string_view created_at() const noexcept
+    {
+        return _json["created_at"].get_string_view();
+    }
+
+    //! The account that caused the notification.
+    [[nodiscard]] inline AccountView account() const noexcept
+    {
+        return AccountView{_json["account"]};
+    }
+
+    //! The status. Invalid for notifications without status.
+    [[nodiscard]] inline StatusView status() const noexcept
+    {
+        return StatusView{_json["status"]};
+    }
+};
+
+/*!
+ *  @brief  View of a [Relationship]
+ *          (https://docs.joinmastodon.org/entities/Relationship/).
+ *
+ *  id() is the ID of the other account.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile entities.hpp mastodonpp/entities.hpp
+ */
+class RelationshipView : public EntityView
+{
+public:
+    using EntityView::EntityView;
+
+    //! True if you follow the account.
+    [[nodiscard]] inline bool following() const noexcept
+    {
+        return _json["following"].get_bool();
+    }
+
+    //! True if you receive the boosts of the account.
+    [[nodiscard]] inline bool showing_reblogs() const noexcept
+    {
+        return _json["showing_reblogs"].get_bool();
+    }
+
+    //! True if the account follows you.
+    [[nodiscard]] inline bool followed_by() const noexcept
+    {
+        return _json["followed_by"].get_bool();
+    }
+
+    //! True if you sent a follow request that is not approved yet.
+    [[nodiscard]] inline bool requested() const noexcept
+    {
+        return _json["requested"].get_bool();
+    }
+
+    //! True if you block the account.
+    [[nodiscard]] inline bool blocking() const noexcept
+    {
+        return _json["blocking"].get_bool();
+    }
+
+    //! True if the account blocks you.
+    [[nodiscard]] inline bool blocked_by() const noexcept
+    {
+        return _json["blocked_by"].get_bool();
+    }
+
+    //! True if you mute the account.
+    [[nodiscard]] inline bool muting() const noexcept
+    {
+        return _json["muting"].get_bool();
+    }
+
+    //! True if you mute the notifications of the account.
+    [[nodiscard]] inline bool muting_notifications() const noexcept
+    {
+        return _json["muting_notifications"].get_bool();
+    }
+
+    //! True if you block the domain of the account.
+    [[nodiscard]] inline bool domain_blocking() const noexcept
+    {
+        return _json["domain_blocking"].get_bool();
+    }
+
+    //! True if you feature the account on your profile.
+    [[nodiscard]] inline bool endorsed() const noexcept
+    {
+        return _json["endorsed"].get_bool();
+    }
+
+    //! Your private note on the account.
+    [[nodiscard]] inline string note() const
+    {
+        return _json["note"].get_string();
+    }
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_ENTITIES_HPP
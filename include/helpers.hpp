@@ -19,6 +19,7 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 //! @headerfile helpers.hpp mastodonpp/helpers.hpp
 
@@ -26,11 +27,15 @@ namespace mastodonpp
 {
 
 using std::string;
+using std::string_view;
+using std::vector;
 
 /*!
  *  @brief  Replaces HTML entities with UTF-8 characters.
  *
- *  Supports named and numbered entities, decimal and hexadecimal.
+ *  Supports named and numbered entities, decimal and hexadecimal. Unknown
+ *  entities are left alone. The result is never longer than the input, so
+ *  this works in place on @a html.
  *
  *  Example:
  *  @code
@@ -44,6 +49,86 @@ using std::string;
  */
 [[nodiscard]] string unescape_html(string html);
 
+/*!
+ *  @brief  Replaces HTML entities with UTF-8 characters and appends the
+ *          result to @a out.
+ *
+ *  Pass the same string for many calls to reuse its capacity.
+ *
+ *  @param  html The HTML to unescape.
+ *  @param  out  The result is appended to this.
+ *
+ *  @since  0.6.0
+ */
+void unescape_html(string_view html, string &out);
+
+/*!
+ *  @brief  Replaces HTML entities with UTF-8 characters, in place.
+ *
+ *  @param  html The HTML to unescape.
+ *
+ *  @since  0.6.0
+ */
+void unescape_html_in_place(string &html);
+
+/*!
+ *  @brief  Converts the HTML of a status to text and appends it to @a out.
+ *
+ *  Made for the markup Mastodon and Pleroma use. Tags are removed, `<br>`
+ *  becomes a line break and paragraphs are separated by an empty line.
+ *  Entities are replaced like in unescape_html(). The invisible parts of
+ *  links are kept, so links are written out in full. Mentions and hashtags
+ *  become `@user` and `#tag`.
+ *
+ *  Example:
+ *  @code
+ *  // Will output: Hi @user!\n\nhttps://example.com/ & more
+ *  std::cout << mastodonpp::html_to_text(
+ *      R"(<p>Hi <span class="h-card"><a href="…">@<span>user</span></a>)"
+ *      R"(</span>!</p><p><a href="https://example.com/">)"
+ *      R"(<span class="invisible">https://</span>example.com/</a> &amp; more)"
+ *      R"(</p>)");
+ *  @endcode
+ *
+ *  @param  html The HTML to convert.
+ *  @param  out  The text is appended to this.
+ *
+ *  @since  0.6.0
+ */
+void html_to_text(string_view html, string &out);
+
+/*!
+ *  @brief  Converts the HTML of a status to text.
+ *
+ *  See html_to_text(string_view, string &).
+ *
+ *  @param  html The HTML to convert.
+ *
+ *  @since  0.6.0
+ */
+[[nodiscard]] inline string html_to_text(const string_view html)
+{
+    string text;
+    html_to_text(html, text);
+    return text;
+}
+
+/*!
+ *  @brief  Converts the HTML of many statuses to text at once.
+ *
+ *  All texts are written into one buffer, which is allocated at most once.
+ *  Reuse @a arena and @a texts for the next batch to avoid even that.
+ *
+ *  @param  html  The HTML to convert.
+ *  @param  arena Holds the texts. Its previous contents are discarded.
+ *  @param  texts Views of the texts in @a arena, in the same order as
+ *                @a html. Its previous contents are discarded.
+ *
+ *  @since  0.6.0
+ */
+void html_to_text(const vector<string_view> &html, string &arena,
+                  vector<string_view> &texts);
+
 } // namespace mastodonpp
 
 #endif // MASTODONPP_HELPERS_HPP
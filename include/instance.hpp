@@ -18,9 +18,14 @@
 #define MASTODONPP_INSTANCE_HPP
 
 #include "curl_wrapper.hpp"
+#include "instance_registry.hpp"
+#include "rate_limiter.hpp"
+#include "single_flight.hpp"
 #include "types.hpp"
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -29,6 +34,8 @@
 namespace mastodonpp
 {
 
+using std::function;
+using std::shared_ptr;
 using std::string;
 using std::string_view;
 using std::uint64_t;
@@ -59,7 +66,8 @@ public:
     explicit Instance(string_view hostname, string_view access_token);
 
     /*!
-     *  @brief  Copy constructor. A new CURLWrapper is constructed.
+     *  @brief  Copy constructor. A new CURLWrapper is constructed, with a
+     *          handle from the same pool.
      *
      *  @since  0.5.2
      */
@@ -139,14 +147,102 @@ public:
         CURLWrapper::set_access_token(access_token);
     }
 
+    /*!
+     *  @brief  Pace requests by the rate limit the server announces.
+     *
+     *  Connection%s and Dispatcher%s that are initialized with this Instance
+     *  afterwards wait for their turn instead of running into HTTP status 429.
+     *  All of them share one RateLimiter per hostname and access token.
+     *  Disabled by default.
+     *
+     *  @since  0.6.0
+     */
+    inline void set_rate_limiting(const bool enable) noexcept
+    {
+        _rate_limiting = enable;
+    }
+
+    /*!
+     *  @brief  Returns the RateLimiter for the hostname and access token, or
+     *          `nullptr` if rate limiting is disabled.
+     *
+     *  Use it to look at the rate_limit_metrics.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline shared_ptr<RateLimiter> get_rate_limiter() const
+    {
+        if (!_rate_limiting)
+        {
+            return nullptr;
+        }
+        return RateLimiter::get(_hostname, _access_token);
+    }
+
+    /*!
+     *  @brief  Let identical `GET` requests that run at the same time share
+     *          one answer.
+     *
+     *  Applies to Connection%s that are initialized with this Instance
+     *  afterwards, in all threads. Requests are identical if the URI,
+     *  including the parameters, and the access token are the same. See
+     *  SingleFlight. Disabled by default.
+     *
+     *  @since  0.6.0
+     */
+    inline void set_request_coalescing(const bool enable) noexcept
+    {
+        _request_coalescing = enable;
+    }
+
+    /*!
+     *  @brief  Returns the SingleFlight, or `nullptr` if request coalescing is
+     *          disabled.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline shared_ptr<SingleFlight> get_single_flight() const
+    {
+        if (!_request_coalescing)
+        {
+            return nullptr;
+        }
+        return SingleFlight::get();
+    }
+
+    /*!
+     *  @brief  Returns the information about the instance.
+     *
+     *  Downloads `/api/v1/instance`, or takes it from the InstanceRegistry if
+     *  that is enabled. Answers from the registry have only the HTTP status
+     *  and the body.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type get_instance_info();
+
+    /*!
+     *  @brief  Returns the custom emojis of the instance.
+     *
+     *  Downloads `/api/v1/custom_emojis`, or takes it from the
+     *  InstanceRegistry if that is enabled. Answers from the registry have
+     *  only the HTTP status and the body.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type get_custom_emojis();
+
     /*!
      *  @brief  Returns the maximum number of characters per post.
      *
-     *  Queries `/api/v1/instance` for `max_toot_chars'. If the instance doesn't
+     *  Queries `/api/v1/instance` for `max_toot_chars` or
+     *  `configuration.statuses.max_characters`. If the instance doesn't
      *  support it, the limit is assumed to be 500.
      *
      *  After the first call, the value is saved internally. Subsequent calls
-     *  return the saved value.
+     *  return the saved value. If the InstanceRegistry is enabled, the
+     *  information about the instance is shared with other Instance%s
+     *  through it.
      *
      *  @since  0.1.0
      */
@@ -168,7 +264,10 @@ public:
      *
      *  Attempts to download the [NodeInfo]
      *  (https://nodeinfo.diaspora.software/protocol.html) of the instance and
-     *  returns it. Not every instance has it.
+     *  returns it. Not every instance has it. If the InstanceRegistry is
+     *  enabled and has the NodeInfo, it is taken from there instead. These
+     *  answers have only the HTTP status and the body, and can be as old as
+     *  the time to live of the registry.
      *
      *  @since  0.3.0
      */
@@ -254,7 +353,8 @@ public:
          *  @since  0.3.0
          */
         explicit ObtainToken(Instance &instance)
-            : _instance{instance}
+            : CURLWrapper{instance.get_hostname()}
+            , _instance{instance}
             , _baseuri{instance.get_baseuri()}
         {
             _instance.copy_connection_properties(*this);
@@ -317,6 +417,27 @@ private:
     vector<string> _post_formats;
     string _cainfo;
     string _useragent;
+    bool _rate_limiting{false};
+    bool _request_coalescing{false};
+
+    /*!
+     *  @brief  Returns metadata from the InstanceRegistry, or downloads and
+     *          stores it.
+     *
+     *  @param  field    The name in the registry.
+     *  @param  download Downloads the metadata.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type
+    get_metadata(string_view field, const function<answer_type()> &download);
+
+    /*!
+     *  @brief  Downloads the NodeInfo.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type download_nodeinfo();
 };
 
 } // namespace mastodonpp
@@ -0,0 +1,185 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_INSTANCE_REGISTRY_HPP
+#define MASTODONPP_INSTANCE_REGISTRY_HPP
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace mastodonpp
+{
+
+using std::less;
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+/*!
+ *  @brief  Remembers the metadata of instances, for all Instance%s of the
+ *          process.
+ *
+ *  Instance::get_instance_info(), Instance::get_nodeinfo(),
+ *  Instance::get_custom_emojis() and everything derived from them, like
+ *  Instance::get_max_chars() and Instance::get_post_formats(), look here
+ *  first and store what they downloaded, if the registry is enabled with
+ *  set_ttl(). The metadata is used for as long as the time to live allows.
+ *  The registry is disabled by default.
+ *
+ *  With set_persistence(), the metadata is also written to a file and read
+ *  back when the program starts again.
+ *
+ *  Example:
+ *  @code
+ *  auto registry{mastodonpp::InstanceRegistry::get()};
+ *  registry->set_ttl(std::chrono::hours{24});
+ *  registry->set_persistence("/var/cache/myapp/instances");
+ *  @endcode
+ *
+ *  All member functions are thread-safe.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile instance_registry.hpp mastodonpp/instance_registry.hpp
+ */
+class InstanceRegistry
+{
+public:
+    /*!
+     *  @brief  Returns the InstanceRegistry of the process.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static shared_ptr<InstanceRegistry> get();
+
+    //! Default constructor.
+    InstanceRegistry() = default;
+
+    //! Copy constructor
+    InstanceRegistry(const InstanceRegistry &other) = delete;
+
+    //! Move constructor
+    InstanceRegistry(InstanceRegistry &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Writes unsaved changes into the file.
+     *
+     *  @since  0.6.0
+     */
+    ~InstanceRegistry() noexcept;
+
+    //! Copy assignment operator
+    InstanceRegistry &operator=(const InstanceRegistry &other) = delete;
+
+    //! Move assignment operator
+    InstanceRegistry &operator=(InstanceRegistry &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Set how long metadata is used. 0 disables the registry, which
+     *          is the default.
+     *
+     *  @since  0.6.0
+     */
+    void set_ttl(seconds ttl);
+
+    /*!
+     *  @brief  Read metadata from @a file and write new metadata into it.
+     *
+     *  Entries in the file are merged with those in memory, the newer ones
+     *  win. Changes are written by flush() and when the registry is
+     *  destroyed; the file is replaced atomically. Pass an empty path to
+     *  stop writing.
+     *
+     *  @since  0.6.0
+     */
+    void set_persistence(string file);
+
+    /*!
+     *  @brief  Look up metadata.
+     *
+     *  @param  hostname The hostname of the instance.
+     *  @param  field    The name of the metadata, like `"nodeinfo"`.
+     *  @param  value    Is set to the metadata.
+     *
+     *  @return false if there is no metadata or it is too old.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool lookup(string_view hostname, string_view field,
+                              string &value);
+
+    /*!
+     *  @brief  Store metadata.
+     *
+     *  @since  0.6.0
+     */
+    void store(string_view hostname, string_view field, string value);
+
+    /*!
+     *  @brief  Forget the metadata of an instance.
+     *
+     *  @since  0.6.0
+     */
+    void erase(string_view hostname);
+
+    /*!
+     *  @brief  Write changes into the file set with set_persistence().
+     *
+     *  Does nothing if nothing changed since the last call. Long-running
+     *  programs should call this from time to time.
+     *
+     *  @since  0.6.0
+     */
+    void flush();
+
+private:
+    struct record
+    {
+        string value;
+        system_clock::time_point fetched;
+    };
+
+    using record_map = map<string, map<string, record, less<>>, less<>>;
+
+    mutex _mutex;
+    //! Serializes writes of the file, so that the newest one wins.
+    mutex _write_mutex;
+    seconds _ttl{0};
+    string _file;
+    //! Records by hostname and field.
+    record_map _records;
+    //! True if _records changed since the file was written.
+    bool _dirty{false};
+
+    //! Merge the records in _file. _mutex has to be locked.
+    void read_file();
+
+    //! Write @a records into @a path.
+    static void write_file(const string &path, const record_map &records);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_INSTANCE_REGISTRY_HPP
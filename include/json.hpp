@@ -0,0 +1,430 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_JSON_HPP
+#define MASTODONPP_JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::int64_t;
+using std::ptrdiff_t;
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::uint8_t;
+using std::vector;
+
+/*!
+ *  @brief  The type of a JSON value.
+ *
+ *  @since  0.6.0
+ */
+enum class json_type : uint8_t
+{
+    invalid,
+    object,
+    array,
+    text,
+    number,
+    boolean,
+    null
+};
+
+/*!
+ *  @brief  A JSON value in the index of a document.
+ *
+ *  The keys of objects are strings, followed by their value.
+ *
+ *  @since  0.6.0
+ */
+struct json_node
+{
+    //! The type of the value.
+    json_type type{json_type::invalid};
+    //! Position of the first character in the document.
+    size_t begin{0};
+    //! Position after the last character in the document.
+    size_t end{0};
+    //! Index of the node after this value and all values in it.
+    size_t next{0};
+};
+
+/*!
+ *  @brief  Builds an index of the values in a JSON document, as it arrives.
+ *
+ *  Data can be fed in chunks of any size. Every byte is looked at only once
+ *  and nothing is copied; the index only holds positions. The document is not
+ *  validated beyond matching brackets.
+ *
+ *  Used by Connection::set_json_indexing().
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile json.hpp mastodonpp/json.hpp
+ */
+class JSONIndexer
+{
+public:
+    /*!
+     *  @brief  Index the next chunk of the document.
+     *
+     *  @since  0.6.0
+     */
+    void feed(string_view data);
+
+    /*!
+     *  @brief  Returns true if the document is complete and no error was
+     *          found.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool complete() const noexcept;
+
+    /*!
+     *  @brief  Returns the index and resets the indexer.
+     *
+     *  @return The index, or an empty vector if the document is not complete.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] vector<json_node> take_nodes();
+
+    /*!
+     *  @brief  Returns the number of bytes fed so far.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline size_t size() const noexcept
+    {
+        return _offset;
+    }
+
+    /*!
+     *  @brief  Forget everything.
+     *
+     *  @since  0.6.0
+     */
+    void reset();
+
+private:
+    enum class state : uint8_t
+    {
+        value,
+        text,
+        escape,
+        scalar
+    };
+
+    vector<json_node> _nodes;
+    vector<size_t> _open;
+    size_t _offset{0};
+    state _state{state::value};
+    bool _failed{false};
+
+    //! Set the end of the last node, which is a string or scalar.
+    void close_last(size_t end);
+};
+
+/*!
+ *  @brief  A view of a value in an indexed JSON document.
+ *
+ *  Nothing is parsed or copied until a value is accessed. The view is only
+ *  valid as long as the document and the index exist. Accessing members of a
+ *  value of the wrong type or that do not exist returns an invalid value.
+ *
+ *  Example:
+ *  @code
+ *  connection.set_json_indexing(true);
+ *  auto answer{connection.get(mastodonpp::API::v1::timelines_public)};
+ *  for (const auto &status : answer.json())
+ *  {
+ *      std::cout << status["account"]["acct"].get_string() << '\n';
+ *  }
+ *  @endcode
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile json.hpp mastodonpp/json.hpp
+ */
+class JSONValue
+{
+public:
+    class iterator;
+
+    //! Constructs an invalid value.
+    JSONValue() = default;
+
+    /*!
+     *  @brief  Construct a view of the value at @a index.
+     *
+     *  @param  document The JSON document.
+     *  @param  nodes    The index of the document, made by JSONIndexer.
+     *  @param  index    The position of the value in @a nodes.
+     *
+     *  @since  0.6.0
+     */
+    JSONValue(string_view document, const vector<json_node> &nodes,
+              size_t index = 0);
+
+    /*!
+     *  @brief  Returns the type of the value.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline json_type type() const noexcept
+    {
+        return valid() ? _nodes[_index].type : json_type::invalid;
+    }
+
+    /*!
+     *  @brief  Returns true if the value exists.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline bool valid() const noexcept
+    {
+        return _nodes != nullptr && _index < _size;
+    }
+
+    /*!
+     *  @brief  Returns true if the value is `null` or invalid.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline bool is_null() const noexcept
+    {
+        return type() == json_type::null || !valid();
+    }
+
+    /*!
+     *  @brief  Returns the JSON text of the value.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] string_view raw() const noexcept;
+
+    /*!
+     *  @brief  Returns the member @a key of an object.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] JSONValue operator[](string_view key) const noexcept;
+
+    /*!
+     *  @brief  Returns the element at @a position of an array.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] JSONValue operator[](size_t position) const noexcept;
+
+    /*!
+     *  @brief  Returns the number of elements of an array or members of an
+     *          object.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] size_t size() const noexcept;
+
+    /*!
+     *  @brief  Returns an iterator to the first element of an array.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] iterator begin() const noexcept;
+
+    //! @copydoc begin
+    [[nodiscard]] iterator end() const noexcept;
+
+    /*!
+     *  @brief  Returns a string, with the escape sequences resolved.
+     *
+     *  @return The string, or an empty string if the value is no string.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] string get_string() const;
+
+    /*!
+     *  @brief  Returns a string without the quotes, as it is in the document.
+     *
+     *  This does not copy anything, but escape sequences are not resolved.
+     *  Good for IDs, URIs and other values that never contain them.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] string_view get_string_view() const noexcept;
+
+    /*!
+     *  @brief  Returns an integer.
+     *
+     *  @param  fallback Is returned if the value is no integer.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] int64_t get_int(int64_t fallback = 0) const noexcept;
+
+    /*!
+     *  @brief  Returns a boolean.
+     *
+     *  @param  fallback Is returned if the value is no boolean.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool get_bool(bool fallback = false) const noexcept;
+
+private:
+    string_view _document;
+    const json_node *_nodes{nullptr};
+    size_t _size{0};
+    size_t _index{0};
+
+    //! Returns a copy of this, pointing to another node.
+    [[nodiscard]] JSONValue at_index(size_t index) const noexcept;
+};
+
+/*!
+ *  @brief  Iterates over the elements of an array.
+ *
+ *  @since  0.6.0
+ */
+class JSONValue::iterator
+{
+public:
+    //! @private
+    using iterator_category = std::forward_iterator_tag;
+    //! @private
+    using value_type = JSONValue;
+    //! @private
+    using difference_type = ptrdiff_t;
+    //! @private
+    using pointer = const JSONValue *;
+    //! @private
+    using reference = JSONValue;
+
+    //! Construct an iterator pointing to the value @a value.
+    explicit iterator(const JSONValue &value)
+        : _value{value}
+    {}
+
+    //! Returns the current element.
+    reference operator*() const
+    {
+        return _value;
+    }
+
+    //! Move to the next element.
+    iterator &operator++()
+    {
+        _value._index = _value._nodes[_value._index].next;
+        return *this;
+    }
+
+    //! Returns true if both point to the same element.
+    bool operator==(const iterator &other) const
+    {
+        return _value._index == other._value._index;
+    }
+
+    //! Returns false if both point to the same element.
+    bool operator!=(const iterator &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    JSONValue _value;
+};
+
+/*!
+ *  @brief  Returns the value at @a path in a JSON document.
+ *
+ *  Looks up one value without building an index and without allocating. The
+ *  document is read only up to the value. Good for picking a few values out
+ *  of a document that is used only once.
+ *
+ *  Example:
+ *  @code
+ *  const auto max_characters{mastodonpp::json_extract(
+ *      answer.body, "configuration.statuses.max_characters")};
+ *  @endcode
+ *
+ *  @param  json The document.
+ *  @param  path The keys of the objects leading to the value, separated by
+ *               `.`.
+ *
+ *  @return The JSON text of the value, or an empty string_view if it was not
+ *          found.
+ *
+ *  @since  0.6.0
+ */
+[[nodiscard]] string_view json_extract(string_view json,
+                                       string_view path) noexcept;
+
+/*!
+ *  @brief  Takes the next element out of a JSON array.
+ *
+ *  Example:
+ *  @code
+ *  auto array{mastodonpp::json_extract(answer.body, "metadata.postFormats")};
+ *  string_view element;
+ *  while (mastodonpp::json_next_element(array, element))
+ *  {
+ *      std::cout << element << '\n';
+ *  }
+ *  @endcode
+ *
+ *  @param  array   The JSON text of the array. Is shortened with every call.
+ *  @param  element The JSON text of the element.
+ *
+ *  @return false if there are no more elements.
+ *
+ *  @since  0.6.0
+ */
+bool json_next_element(string_view &array, string_view &element) noexcept;
+
+/*!
+ *  @brief  Returns the JSON text of a string as string.
+ *
+ *  @param  json The JSON text of the string, with quotes.
+ *
+ *  @return The string with the escape sequences resolved, or an empty string
+ *          if @a json is no string.
+ *
+ *  @since  0.6.0
+ */
+[[nodiscard]] string json_to_string(string_view json);
+
+/*!
+ *  @brief  Resolve the escape sequences in a JSON string.
+ *
+ *  @param  escaped The contents of the string, without quotes.
+ *  @param  out     The result is appended to this.
+ *
+ *  @since  0.6.0
+ */
+void unescape_json(string_view escaped, string &out);
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_JSON_HPP
@@ -19,10 +19,24 @@
 
 #include "api.hpp"
 #include "connection.hpp"
+#include "dispatcher.hpp"
+#include "entities.hpp"
 #include "exceptions.hpp"
 #include "helpers.hpp"
 #include "instance.hpp"
+#include "instance_registry.hpp"
+#include "json.hpp"
+#include "media_uploader.hpp"
+#include "paginator.hpp"
+#include "rate_limiter.hpp"
+#include "response_cache.hpp"
+#include "retry.hpp"
+#include "shared_connection.hpp"
+#include "single_flight.hpp"
+#include "sse_parser.hpp"
 #include "types.hpp"
+#include "uri_template.hpp"
+#include "websocket_stream.hpp"
 
 /*!
  *  @mainpage mastodonpp Reference
@@ -74,6 +88,9 @@
  *  * All text input is expected to be UTF-8.
  *  * To send a file, use “<tt>\@file:</tt>” followed by the file name as value
  *    in the @link mastodonpp::parametermap parametermap@endlink.
+ *  * Placeholders in endpoints, like `<ID>`, are replaced with the parameter
+ *    of the same name, like `id`. If a parameter is missing, a
+ *    mastodonpp::CURLException is thrown.
  *
  *  @section exceptions Exceptions
  *
@@ -95,6 +112,9 @@
  *  mastodonpp::Connection Connection@endlink%s as you want from one @link
  *  mastodonpp::Instance Instance@endlink.
  *
+ *  A @link mastodonpp::Dispatcher Dispatcher@endlink can be used from many
+ *  threads at once. It makes all requests concurrently on its own thread.
+ *
  *  If you are using libcurl with OpenSSL before 1.1.0, please read
  *  [libcurl-thread(3)](https://curl.haxx.se/libcurl/c/threadsafe.html).
  *
@@ -107,6 +127,11 @@
  *  @example example07_delete_status.cpp
  *  @example example08_obtain_token.cpp
  *  @example example09_nlohmann_json.cpp
+ *  @example example10_dispatcher.cpp
+ *  @example example11_stream_callback.cpp
+ *  @example example12_websocket.cpp
+ *  @example example13_paginator.cpp
+ *  @example example14_json_views.cpp
  */
 
 /*!
@@ -0,0 +1,218 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_MEDIA_UPLOADER_HPP
+#define MASTODONPP_MEDIA_UPLOADER_HPP
+
+#include "dispatcher.hpp"
+#include "instance.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::function;
+using std::future;
+using std::mutex;
+using std::shared_ptr;
+using std::size_t;
+using std::string;
+using std::chrono::milliseconds;
+
+/*!
+ *  @brief  The result of an upload with MediaUploader.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile media_uploader.hpp mastodonpp/media_uploader.hpp
+ */
+struct media_upload
+{
+    /*!
+     *  @brief  The ID of the media attachment, ready to be used in
+     *          `media_ids` of API::v1::statuses.
+     *
+     *  Empty if the upload or the processing failed.
+     */
+    string id;
+
+    /*!
+     *  @brief  The last answer of the server.
+     *
+     *  The body is the media attachment if the upload succeeded.
+     */
+    answer_type answer;
+
+    /*!
+     *  @brief  Returns true if the media attachment is ready.
+     *
+     *  @since  0.6.0
+     */
+    explicit operator bool() const noexcept
+    {
+        return !id.empty();
+    }
+};
+
+/*!
+ *  @brief  Function that is called with the result of an upload.
+ *
+ *  @since  0.6.0
+ */
+using upload_callback = function<void(media_upload)>;
+
+/*!
+ *  @brief  Uploads media attachments concurrently, without blocking a thread.
+ *
+ *  The files are sent to API::v2::media with a Dispatcher. If the server
+ *  answers with HTTP status 202, the attachment is still being processed and
+ *  API::v1::media_id is polled until it is ready. Waiting for the next poll
+ *  does not block anything, so the other uploads go on in the meantime.
+ *
+ *  Mastodon has no API to upload a file in parts, so every file is sent in
+ *  one request.
+ *
+ *  The data of the attachments has to stay valid until the upload is
+ *  finished. The Instance has to outlive the MediaUploader. Uploads that are
+ *  not finished when the MediaUploader is destroyed are aborted.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::MediaUploader uploader{instance};
+ *  std::vector<std::future<mastodonpp::media_upload>> uploads;
+ *  for (const auto &video : videos)
+ *  {
+ *      uploads.push_back(uploader.upload(
+ *          mastodonpp::attachment{video, "cat.mp4", "video/mp4"}));
+ *  }
+ *  std::vector<std::string_view> media_ids;
+ *  for (auto &upload : uploads)
+ *  {
+ *      media_ids.push_back(upload.get().id);
+ *  }
+ *  @endcode
+ *
+ *  All member functions are thread-safe.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile media_uploader.hpp mastodonpp/media_uploader.hpp
+ */
+class MediaUploader
+{
+public:
+    /*!
+     *  @brief  Construct a new MediaUploader.
+     *
+     *  @param  instance An Instance with the access data.
+     *
+     *  @since  0.6.0
+     */
+    explicit MediaUploader(const Instance &instance);
+
+    /*!
+     *  @brief  Upload a file.
+     *
+     *  @param  file       The file.
+     *  @param  parameters More parameters, like `description` or `focus`.
+     *  @param  progress   Is called with the progress of the upload, from
+     *                     the thread of the Dispatcher.
+     *
+     *  @return A future that becomes ready when the attachment is processed
+     *          or the upload failed.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] future<media_upload>
+    upload(const attachment &file, const parametermap &parameters = {},
+           progress_callback progress = {});
+
+    /*!
+     *  @brief  Upload a file and call a function with the result.
+     *
+     *  The callbacks are called from the thread of the Dispatcher. Do not
+     *  block in them.
+     *
+     *  @param  file       The file.
+     *  @param  parameters More parameters, like `description` or `focus`.
+     *  @param  callback   Is called with the result.
+     *  @param  progress   Is called with the progress of the upload.
+     *
+     *  @since  0.6.0
+     */
+    void upload(const attachment &file, const parametermap &parameters,
+                upload_callback callback, progress_callback progress = {});
+
+    /*!
+     *  @brief  Set how often and how long to wait for the processing.
+     *
+     *  Applies to uploads started afterwards.
+     *
+     *  @param  interval The time between two polls. Default is 1 second.
+     *  @param  timeout  The maximum time to wait for the processing. Default
+     *                   is 10 minutes.
+     *
+     *  @since  0.6.0
+     */
+    void set_polling(milliseconds interval, milliseconds timeout);
+
+    /*!
+     *  @brief  Limit the number of simultaneously open connections.
+     *
+     *  See Dispatcher::set_max_connections().
+     *
+     *  @since  0.6.0
+     */
+    void set_max_connections(long max); // NOLINT(google-runtime-int)
+
+    /*!
+     *  @brief  Returns the number of uploads that are not finished.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] size_t get_active_uploads() const noexcept;
+
+private:
+    struct Upload;
+
+    mutex _mutex;
+    milliseconds _poll_interval{1000};
+    milliseconds _poll_timeout{std::chrono::minutes{10}};
+    atomic<size_t> _active_uploads{0};
+    //! Declared last, so that it is destroyed first.
+    Dispatcher _dispatcher;
+
+    //! Handle an answer of the server.
+    void process(const shared_ptr<Upload> &upload, answer_type answer);
+
+    //! Call the callback of @a upload.
+    void finish(const shared_ptr<Upload> &upload, answer_type answer,
+                bool success);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_MEDIA_UPLOADER_HPP
@@ -0,0 +1,299 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_PAGINATOR_HPP
+#define MASTODONPP_PAGINATOR_HPP
+
+#include "connection.hpp"
+#include "instance.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::condition_variable;
+using std::deque;
+using std::exception_ptr;
+using std::function;
+using std::mutex;
+using std::ptrdiff_t;
+using std::size_t;
+using std::string;
+using std::thread;
+using std::unique_ptr;
+
+/*!
+ *  @brief  Function that decides whether to stop after a page.
+ *
+ *  Return `true` to stop. The page is still returned by the Paginator.
+ *
+ *  @since  0.6.0
+ */
+using stop_condition = function<bool(const answer_type &)>;
+
+/*!
+ *  @brief  Function that fetches a page with the given parameters.
+ *
+ *  @since  0.6.0
+ */
+using page_fetcher = function<answer_type(const parametermap &)>;
+
+/*!
+ *  @brief  Follows the pagination of an endpoint and fetches pages ahead.
+ *
+ *  The first page is requested by the constructor. Whenever a page arrives,
+ *  the next one is requested right away on a background thread, until
+ *  @a depth pages are waiting to be taken. So the next page is usually there
+ *  by the time you are done with the current one.
+ *
+ *  The Paginator stops after the last page (no `rel="next"` in the `Link`
+ *  header or an empty list), after a failed request, or if the stop condition
+ *  returns `true`. Failed requests are returned like every other page.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::Paginator followers{instance,
+ *                                  mastodonpp::API::v1::accounts_id_followers,
+ *                                  {{"id", "1"}, {"limit", "80"}}};
+ *  for (const auto &page : followers)
+ *  {
+ *      std::cout << page.body << '\n';
+ *  }
+ *  @endcode
+ *
+ *  The Instance has to outlive the Paginator. Do not use a Paginator from
+ *  more than one thread at once.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile paginator.hpp mastodonpp/paginator.hpp
+ */
+class Paginator
+{
+public:
+    /*!
+     *  @brief  Construct a new Paginator and request the first page.
+     *
+     *  The endpoint and the parameters are copied, they do not need to
+     *  outlive the call.
+     *
+     *  @param  instance   An Instance with the access data.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *  @param  depth      How many pages to fetch ahead. At least 1.
+     *  @param  stop       Is called with every page, on the background
+     *                     thread. Return `true` to stop after this page.
+     *
+     *  @since  0.6.0
+     */
+    explicit Paginator(const Instance &instance,
+                       const endpoint_variant &endpoint,
+                       const parametermap &parameters, size_t depth = 1,
+                       stop_condition stop = {});
+
+    /*!
+     *  @brief  Construct a new Paginator that fetches pages with @a fetch.
+     *
+     *  Use this to fetch pages with your own Connection, with a
+     *  retry_policy or a ResponseCache for example. @a fetch is called on
+     *  the background thread, with @a parameters for the first page and with
+     *  @a parameters plus those from the `Link` header for the following
+     *  pages. The destructor waits until @a fetch returns.
+     *
+     *  @param  fetch      Fetches a page.
+     *  @param  parameters A map of parameters.
+     *  @param  depth      How many pages to fetch ahead. At least 1.
+     *  @param  stop       Is called with every page, on the background
+     *                     thread. Return `true` to stop after this page.
+     *
+     *  @since  0.6.0
+     */
+    explicit Paginator(page_fetcher fetch, const parametermap &parameters,
+                       size_t depth = 1, stop_condition stop = {});
+
+    //! Copy constructor
+    Paginator(const Paginator &other) = delete;
+
+    //! Move constructor
+    Paginator(Paginator &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Cancels the running request and waits for the background
+     *          thread.
+     *
+     *  @since  0.6.0
+     */
+    ~Paginator() noexcept;
+
+    //! Copy assignment operator
+    Paginator &operator=(const Paginator &other) = delete;
+
+    //! Move assignment operator
+    Paginator &operator=(Paginator &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Iterates over the pages. Incrementing waits for the next page.
+     *
+     *  @since  0.6.0
+     */
+    class iterator
+    {
+    public:
+        //! @private
+        using iterator_category = std::input_iterator_tag;
+        //! @private
+        using value_type = answer_type;
+        //! @private
+        using difference_type = ptrdiff_t;
+        //! @private
+        using pointer = const answer_type *;
+        //! @private
+        using reference = const answer_type &;
+
+        /*!
+         *  @brief  Construct an iterator and take the next page.
+         *
+         *  @param  paginator The Paginator, `nullptr` for the end.
+         *
+         *  @since  0.6.0
+         */
+        explicit iterator(Paginator *paginator);
+
+        //! Returns the current page.
+        reference operator*() const
+        {
+            return _page;
+        }
+
+        //! Returns the current page.
+        pointer operator->() const
+        {
+            return &_page;
+        }
+
+        //! Take the next page.
+        iterator &operator++();
+
+        //! Returns true if both iterators are at the end.
+        bool operator==(const iterator &other) const
+        {
+            return _paginator == other._paginator;
+        }
+
+        //! Returns false if both iterators are at the end.
+        bool operator!=(const iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        Paginator *_paginator;
+        answer_type _page;
+    };
+
+    /*!
+     *  @brief  Returns an iterator to the next page that was not taken yet.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] iterator begin()
+    {
+        return iterator{this};
+    }
+
+    /*!
+     *  @brief  Returns the end iterator.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] iterator end()
+    {
+        return iterator{nullptr};
+    }
+
+    /*!
+     *  @brief  Take the next page. Waits until it has arrived.
+     *
+     *  If the background thread failed with an exception, it is rethrown.
+     *
+     *  @param  page The page is moved into this.
+     *
+     *  @return false if there are no more pages.
+     *
+     *  @since  0.6.0
+     */
+    bool next_page(answer_type &page);
+
+private:
+    unique_ptr<Connection> _connection;
+    endpoint_variant _endpoint;
+    string _endpoint_storage;
+    // Deques, because the strings must not move.
+    deque<string> _parameter_storage;
+    parametermap _parameters;
+    const size_t _depth;
+    stop_condition _stop;
+    page_fetcher _fetch;
+
+    mutex _mutex;
+    condition_variable _page_ready;
+    condition_variable _space_free;
+    deque<answer_type> _pages;
+    bool _finished{false};
+    //! Also read by the progress callback of the Connection.
+    atomic<bool> _stopped{false};
+    exception_ptr _exception;
+    thread _thread;
+
+    /*!
+     *  @brief  Copy the parameters and start the background thread.
+     *
+     *  @since  0.6.0
+     */
+    void start(const parametermap &parameters);
+
+    /*!
+     *  @brief  Runs fetch_pages() on the background thread and keeps
+     *          exceptions for next_page().
+     *
+     *  @since  0.6.0
+     */
+    void run() noexcept;
+
+    /*!
+     *  @brief  Fetches pages until the last one or until stopped.
+     *
+     *  @since  0.6.0
+     */
+    void fetch_pages();
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_PAGINATOR_HPP
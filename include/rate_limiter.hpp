@@ -0,0 +1,165 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_RATE_LIMITER_HPP
+#define MASTODONPP_RATE_LIMITER_HPP
+
+#include "types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::greater;
+using std::int64_t;
+using std::mutex;
+using std::priority_queue;
+using std::shared_ptr;
+using std::string_view;
+using std::uint64_t;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/*!
+ *  @brief  Statistics of a RateLimiter.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile rate_limiter.hpp mastodonpp/rate_limiter.hpp
+ */
+struct rate_limit_metrics
+{
+    //! Requests that are waiting for their turn right now.
+    size_t queued{0};
+
+    //! All requests so far.
+    uint64_t requests{0};
+
+    //! Requests that had to wait.
+    uint64_t delayed{0};
+
+    //! Answers with HTTP status 429 (Too Many Requests).
+    uint64_t rejected{0};
+
+    //! The time all requests had to wait, added up.
+    milliseconds total_wait{0};
+
+    //! The longest time a request had to wait.
+    milliseconds max_wait{0};
+
+    //! The last `X-RateLimit-Limit` the server sent, or -1.
+    int64_t limit{-1};
+
+    //! The last `X-RateLimit-Remaining` the server sent, or -1.
+    int64_t remaining{-1};
+};
+
+/*!
+ *  @brief  Paces requests by the rate limit the server announces.
+ *
+ *  Mastodon tells in the headers `X-RateLimit-Limit`, `X-RateLimit-Remaining`
+ *  and `X-RateLimit-Reset` how many requests are left until when. The
+ *  RateLimiter is a token bucket that is refilled from these headers after
+ *  every answer. While enough tokens are left, requests are sent immediately.
+ *  When they run low, the remaining requests are spread evenly until the
+ *  reset. When none are left, requests wait for the reset instead of being
+ *  rejected with HTTP status 429.
+ *
+ *  There is one RateLimiter per hostname and access token, shared by all
+ *  Connection%s and Dispatcher%s. Enable it with Instance::set_rate_limiting().
+ *  Streams are not paced.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile rate_limiter.hpp mastodonpp/rate_limiter.hpp
+ */
+class RateLimiter
+{
+public:
+    /*!
+     *  @brief  Returns the RateLimiter for a hostname and access token.
+     *
+     *  It is created on the first call and lives as long as a Connection,
+     *  Dispatcher or the caller holds it.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static shared_ptr<RateLimiter>
+    get(string_view hostname, string_view access_token);
+
+    /*!
+     *  @brief  Reserve a request.
+     *
+     *  Every reservation has to be followed by exactly one call to release().
+     *
+     *  @return The time at which the request may be sent.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] steady_clock::time_point reserve();
+
+    /*!
+     *  @brief  Finish a reserved request and read the rate limit headers.
+     *
+     *  @param  answer The answer to the request. Pass an empty answer if the
+     *                 request was not sent.
+     *
+     *  @since  0.6.0
+     */
+    void release(const answer_type &answer);
+
+    /*!
+     *  @brief  Returns the statistics.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] rate_limit_metrics get_metrics();
+
+private:
+    using time_point = steady_clock::time_point;
+
+    mutex _mutex;
+    //! True if the server told us the limit of the current window.
+    bool _known{false};
+    int64_t _limit{0};
+    //! Requests left in this window, minus those in flight.
+    int64_t _tokens{0};
+    //! Requests sent after the reset, because there were no tokens left.
+    int64_t _overdrawn{0};
+    size_t _in_flight{0};
+    time_point _reset;
+    //! The length of a window. 5 minutes in Mastodon, until we know better.
+    steady_clock::duration _window{std::chrono::minutes{5}};
+    time_point _next_slot;
+    priority_queue<time_point, vector<time_point>, greater<>> _scheduled;
+    rate_limit_metrics _metrics;
+
+    //! Forget the slots that have passed.
+    void drop_past_slots(time_point now);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_RATE_LIMITER_HPP
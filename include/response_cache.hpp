@@ -0,0 +1,328 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_RESPONSE_CACHE_HPP
+#define MASTODONPP_RESPONSE_CACHE_HPP
+
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::list;
+using std::mutex;
+using std::pair;
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::uint64_t;
+using std::unordered_map;
+using std::vector;
+using std::chrono::system_clock;
+
+/*!
+ *  @brief  A response in a ResponseCache.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile response_cache.hpp mastodonpp/response_cache.hpp
+ */
+struct cache_entry
+{
+    //! The answer, as it was received.
+    answer_type answer;
+
+    //! Until when the answer can be used without asking the server.
+    system_clock::time_point expires;
+
+    /*!
+     *  @brief  Returns true if the answer can be used without asking the
+     *          server.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline bool fresh() const noexcept
+    {
+        return system_clock::now() < expires;
+    }
+
+    /*!
+     *  @brief  Returns the headers that ask the server whether the answer is
+     *          still valid.
+     *
+     *  `If-None-Match` with the `ETag` and `If-Modified-Since` with the
+     *  `Last-Modified` header of the answer, if they are there.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] vector<string> conditional_headers() const;
+};
+
+/*!
+ *  @brief  Statistics of a ResponseCache.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile response_cache.hpp mastodonpp/response_cache.hpp
+ */
+struct cache_metrics
+{
+    //! Answers taken from the cache without asking the server.
+    uint64_t hits{0};
+
+    //! Answers taken from the cache after the server answered 304.
+    uint64_t revalidated{0};
+
+    //! Answers that had to be downloaded.
+    uint64_t misses{0};
+
+    //! Answers that were stored.
+    uint64_t stored{0};
+
+    //! Answers that were removed to make room for others.
+    uint64_t evicted{0};
+};
+
+/*!
+ *  @brief  Base of the caches for answers to `GET` requests.
+ *
+ *  Answers with HTTP status 200 are stored, unless `Cache-Control` contains
+ *  `no-store`. They are used without asking the server for as long as
+ *  `Cache-Control: max-age` or `Expires` allow. After that, or always if
+ *  `Cache-Control` contains `no-cache`, the server is asked with a conditional
+ *  request whether the answer is still valid. If it answers 304 (Not
+ *  Modified), the stored answer is returned. Answers without freshness
+ *  information and without `ETag` or `Last-Modified` are not stored.
+ *
+ *  Answers are stored per method, URI and access token. Pass a cache to
+ *  Connection::set_response_cache(). A cache can be shared by many
+ *  Connection%s, from many threads.
+ *
+ *  Derive from this class to implement other backends. load(), save() and
+ *  remove() must be thread-safe.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile response_cache.hpp mastodonpp/response_cache.hpp
+ */
+class ResponseCache
+{
+public:
+    //! Default constructor.
+    ResponseCache() = default;
+
+    //! Copy constructor
+    ResponseCache(const ResponseCache &other) = delete;
+
+    //! Move constructor
+    ResponseCache(ResponseCache &&other) noexcept = delete;
+
+    //! Destructor
+    virtual ~ResponseCache() noexcept = default;
+
+    //! Copy assignment operator
+    ResponseCache &operator=(const ResponseCache &other) = delete;
+
+    //! Move assignment operator
+    ResponseCache &operator=(ResponseCache &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Returns the key of a request.
+     *
+     *  The access token is hashed, so that it is not written to disk.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static string make_key(string_view uri,
+                                         string_view access_token);
+
+    /*!
+     *  @brief  Look up the answer to a request.
+     *
+     *  @param  key   The key, made with make_key().
+     *  @param  entry Is set to the stored answer.
+     *
+     *  @return true if an answer was found, fresh or not.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool lookup(const string &key, cache_entry &entry);
+
+    /*!
+     *  @brief  Process the answer of the server.
+     *
+     *  Stores the answer if allowed. If the server answered 304 and
+     *  @a stale is not `nullptr`, the stored answer is refreshed and returned.
+     *
+     *  @param  key    The key, made with make_key().
+     *  @param  answer The answer of the server.
+     *  @param  stale  The answer found by lookup(), or `nullptr`.
+     *
+     *  @return The answer to return to the caller.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type update(const string &key, answer_type answer,
+                                     cache_entry *stale);
+
+    /*!
+     *  @brief  Returns the statistics.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] cache_metrics get_metrics() const noexcept;
+
+protected:
+    /*!
+     *  @brief  Read an entry.
+     *
+     *  @return false if there is none.
+     *
+     *  @since  0.6.0
+     */
+    virtual bool load(const string &key, cache_entry &entry) = 0;
+
+    /*!
+     *  @brief  Write an entry, replacing the old one.
+     *
+     *  @since  0.6.0
+     */
+    virtual void save(const string &key, const cache_entry &entry) = 0;
+
+    /*!
+     *  @brief  Remove an entry, if it exists.
+     *
+     *  @since  0.6.0
+     */
+    virtual void remove(const string &key) = 0;
+
+    /*!
+     *  @brief  Count an entry that was removed to make room.
+     *
+     *  @since  0.6.0
+     */
+    inline void count_eviction() noexcept
+    {
+        ++_evicted;
+    }
+
+private:
+    atomic<uint64_t> _hits{0};
+    atomic<uint64_t> _revalidated{0};
+    atomic<uint64_t> _misses{0};
+    atomic<uint64_t> _stored{0};
+    atomic<uint64_t> _evicted{0};
+};
+
+/*!
+ *  @brief  Keeps answers in memory and removes the least recently used when
+ *          it is full.
+ *
+ *  Example:
+ *  @code
+ *  auto cache{std::make_shared<mastodonpp::MemoryCache>(500)};
+ *  connection.set_response_cache(cache);
+ *  @endcode
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile response_cache.hpp mastodonpp/response_cache.hpp
+ */
+class MemoryCache : public ResponseCache
+{
+public:
+    /*!
+     *  @brief  Construct a new MemoryCache.
+     *
+     *  @param  capacity The maximum number of answers.
+     *
+     *  @since  0.6.0
+     */
+    explicit MemoryCache(size_t capacity = 100);
+
+protected:
+    bool load(const string &key, cache_entry &entry) override;
+    void save(const string &key, const cache_entry &entry) override;
+    void remove(const string &key) override;
+
+private:
+    using entry_list = list<pair<string, cache_entry>>;
+
+    mutex _mutex;
+    const size_t _capacity;
+    //! The most recently used entry is at the front.
+    entry_list _entries;
+    unordered_map<string, entry_list::iterator> _index;
+};
+
+/*!
+ *  @brief  Keeps answers in files in a directory.
+ *
+ *  Survives restarts of the program and can be shared by processes. Every
+ *  answer is one file, which is replaced atomically. Nothing is removed
+ *  automatically; delete the directory to clear the cache.
+ *
+ *  Example:
+ *  @code
+ *  auto cache{std::make_shared<mastodonpp::DiskCache>(
+ *      std::string{std::getenv("HOME")} + "/.cache/myapp")};
+ *  connection.set_response_cache(cache);
+ *  @endcode
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile response_cache.hpp mastodonpp/response_cache.hpp
+ */
+class DiskCache : public ResponseCache
+{
+public:
+    /*!
+     *  @brief  Construct a new DiskCache.
+     *
+     *  @param  directory The directory. Is created if it does not exist.
+     *
+     *  @since  0.6.0
+     */
+    explicit DiskCache(string directory);
+
+protected:
+    bool load(const string &key, cache_entry &entry) override;
+    void save(const string &key, const cache_entry &entry) override;
+    void remove(const string &key) override;
+
+private:
+    const string _directory;
+
+    //! Returns the path of the file for @a key.
+    [[nodiscard]] string file_path(const string &key) const;
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_RESPONSE_CACHE_HPP
@@ -0,0 +1,255 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_RETRY_HPP
+#define MASTODONPP_RETRY_HPP
+
+#include "curl_wrapper.hpp"
+#include "types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace mastodonpp
+{
+
+using std::mutex;
+using std::shared_ptr;
+using std::size_t;
+using std::uint64_t;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/*!
+ *  @brief  When and how often failed requests are repeated.
+ *
+ *  A request is repeated if libcurl reports a network error or the server
+ *  answers with HTTP status 408, 425, 429, 500, 502, 503 or 504. `GET`, `PUT`
+ *  and `DELETE` requests are repeated in all these cases. `POST` and `PATCH`
+ *  requests are only repeated if they were certainly not processed, that is
+ *  if no connection could be made or the answer was 429, unless
+ *  #retry_non_idempotent is true.
+ *
+ *  The wait before the next attempt doubles with every attempt, starting at
+ *  #initial_backoff and capped at #max_backoff. With #jitter, a random time
+ *  between 0 and that is waited instead, so that many clients do not come
+ *  back at once. If the server sends `Retry-After`, at least that long is
+ *  waited.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::retry_policy policy;
+ *  policy.max_attempts = 4;
+ *  policy.deadline = std::chrono::seconds{30};
+ *  connection.set_retry_policy(policy);
+ *  @endcode
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile retry.hpp mastodonpp/retry.hpp
+ */
+struct retry_policy
+{
+    //! The number of attempts, including the first. 1 disables retries.
+    size_t max_attempts{3};
+
+    //! The wait before the first retry.
+    milliseconds initial_backoff{500};
+
+    //! The longest wait between two attempts, not counting `Retry-After`.
+    milliseconds max_backoff{30000};
+
+    //! Wait a random part of the backoff.
+    bool jitter{true};
+
+    /*!
+     *  @brief  The time all attempts of a request may take together. 0 means
+     *          no limit.
+     *
+     *  Every attempt is aborted when the deadline is reached, and no attempt
+     *  is started if the wait would end after it.
+     */
+    milliseconds deadline{0};
+
+    //! Repeat `POST` and `PATCH` requests like the others.
+    bool retry_non_idempotent{false};
+
+    /*!
+     *  @brief  Retries may be at most this part of the first attempts, in the
+     *          long run.
+     *
+     *  Keeps retries from multiplying the load on a server that is already
+     *  failing.
+     */
+    double budget_ratio{0.1};
+
+    //! Retries that are allowed before the ratio kicks in.
+    size_t budget_reserve{10};
+};
+
+/*!
+ *  @brief  Statistics of a RetryBudget.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile retry.hpp mastodonpp/retry.hpp
+ */
+struct retry_metrics
+{
+    //! First attempts.
+    uint64_t requests{0};
+
+    //! Retries that were made.
+    uint64_t retries{0};
+
+    //! Retries that were not made because the budget was used up.
+    uint64_t denied{0};
+};
+
+/*!
+ *  @brief  Limits the number of retries in relation to the number of
+ *          requests.
+ *
+ *  Every first attempt adds retry_policy::budget_ratio to the budget, every
+ *  retry takes 1 from it. The budget starts with, and never holds more than,
+ *  retry_policy::budget_reserve.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile retry.hpp mastodonpp/retry.hpp
+ */
+class RetryBudget
+{
+public:
+    /*!
+     *  @brief  Construct a new RetryBudget.
+     *
+     *  @since  0.6.0
+     */
+    explicit RetryBudget(const retry_policy &policy);
+
+    /*!
+     *  @brief  Count a first attempt.
+     *
+     *  @since  0.6.0
+     */
+    void deposit();
+
+    /*!
+     *  @brief  Take a retry out of the budget.
+     *
+     *  @return false if the budget is used up.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool withdraw();
+
+    /*!
+     *  @brief  Returns the statistics.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] retry_metrics get_metrics();
+
+private:
+    mutex _mutex;
+    const double _ratio;
+    const double _reserve;
+    double _balance;
+    retry_metrics _metrics;
+};
+
+/*!
+ *  @brief  The retries of one request.
+ *
+ *  Meant for internal use by Connection and Dispatcher.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile retry.hpp mastodonpp/retry.hpp
+ */
+class RetryState
+{
+public:
+    /*!
+     *  @brief  Start counting the attempts of a request.
+     *
+     *  @param  policy The policy.
+     *  @param  budget The budget, shared with other requests.
+     *  @param  method The HTTP method of the request.
+     *
+     *  @since  0.6.0
+     */
+    RetryState(const retry_policy &policy, shared_ptr<RetryBudget> budget,
+               http_method method);
+
+    /*!
+     *  @brief  Decide whether to repeat the request after @a answer.
+     *
+     *  @return true if the request should be repeated at next_attempt().
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool retry(const answer_type &answer);
+
+    /*!
+     *  @brief  Returns when the next attempt may start.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline steady_clock::time_point next_attempt() const noexcept
+    {
+        return _next_attempt;
+    }
+
+    /*!
+     *  @brief  Returns the time left until the deadline, at least 1 ms, or 0
+     *          if there is no deadline.
+     *
+     *  Meant to be passed to `CURLOPT_TIMEOUT_MS`.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] milliseconds time_left() const noexcept;
+
+    /*!
+     *  @brief  Returns the number of attempts made so far.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline size_t get_attempts() const noexcept
+    {
+        return _attempts;
+    }
+
+private:
+    const retry_policy _policy;
+    shared_ptr<RetryBudget> _budget;
+    const http_method _method;
+    const steady_clock::time_point _start;
+    steady_clock::time_point _next_attempt;
+    size_t _attempts{1};
+
+    //! Returns the backoff before the next attempt, without `Retry-After`.
+    [[nodiscard]] milliseconds backoff() const;
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_RETRY_HPP
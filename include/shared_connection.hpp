@@ -0,0 +1,224 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_SHARED_CONNECTION_HPP
+#define MASTODONPP_SHARED_CONNECTION_HPP
+
+#include "connection.hpp"
+#include "instance.hpp"
+#include "response_cache.hpp"
+#include "retry.hpp"
+#include "types.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::condition_variable;
+using std::mutex;
+using std::optional;
+using std::shared_ptr;
+using std::size_t;
+using std::uint64_t;
+using std::unique_ptr;
+using std::vector;
+
+/*!
+ *  @brief  A Connection that can be used from many threads at once.
+ *
+ *  Every request borrows a Connection from a pool and gives it back when it
+ *  is finished. Connection%s are only created when all others are busy, so
+ *  there are as many as requests ran at the same time, not one per thread.
+ *  Every Connection keeps its network connections open between requests,
+ *  and all of them share the DNS cache and the TLS sessions of the host.
+ *
+ *  The settings are applied to all Connection%s of the pool. The Instance has
+ *  to outlive the SharedConnection.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::SharedConnection connection{instance};
+ *  std::vector<std::thread> workers;
+ *  for (const auto *id : {"1", "2", "3"})
+ *  {
+ *      workers.emplace_back(
+ *          [&connection, id]
+ *          {
+ *              auto answer{connection.get(
+ *                  mastodonpp::API::v1::accounts_id, {{"id", id}})};
+ *          });
+ *  }
+ *  @endcode
+ *
+ *  All member functions are thread-safe.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile shared_connection.hpp mastodonpp/shared_connection.hpp
+ */
+class SharedConnection
+{
+public:
+    /*!
+     *  @brief  Construct a new SharedConnection.
+     *
+     *  @param  instance        An Instance with the access data.
+     *  @param  max_connections The maximum number of Connection%s. Requests
+     *                          above that wait for a Connection to become
+     *                          available. 0 means no limit.
+     *
+     *  @since  0.6.0
+     */
+    explicit SharedConnection(const Instance &instance,
+                              size_t max_connections = 0);
+
+    //! Copy constructor
+    SharedConnection(const SharedConnection &other) = delete;
+
+    //! Move constructor
+    SharedConnection(SharedConnection &&other) noexcept = delete;
+
+    //! Destructor
+    ~SharedConnection() noexcept;
+
+    //! Copy assignment operator
+    SharedConnection &operator=(const SharedConnection &other) = delete;
+
+    //! Move assignment operator
+    SharedConnection &operator=(SharedConnection &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Make a HTTP request.
+     *
+     *  @param  method     The HTTP method.
+     *  @param  endpoint   Endpoint as API::endpoint_type or `std::string_view`.
+     *  @param  parameters A map of parameters.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type request(const http_method &method,
+                                      const endpoint_variant &endpoint,
+                                      const parametermap &parameters);
+
+    //! Make a HTTP GET call. See Connection::get().
+    [[nodiscard]] inline answer_type get(const endpoint_variant &endpoint,
+                                         const parametermap &parameters = {})
+    {
+        return request(http_method::GET, endpoint, parameters);
+    }
+
+    //! Make a HTTP POST call. See Connection::post().
+    [[nodiscard]] inline answer_type post(const endpoint_variant &endpoint,
+                                          const parametermap &parameters = {})
+    {
+        return request(http_method::POST, endpoint, parameters);
+    }
+
+    //! Make a HTTP PATCH call. See Connection::patch().
+    [[nodiscard]] inline answer_type patch(const endpoint_variant &endpoint,
+                                           const parametermap &parameters = {})
+    {
+        return request(http_method::PATCH, endpoint, parameters);
+    }
+
+    //! Make a HTTP PUT call. See Connection::put().
+    [[nodiscard]] inline answer_type put(const endpoint_variant &endpoint,
+                                         const parametermap &parameters = {})
+    {
+        return request(http_method::PUT, endpoint, parameters);
+    }
+
+    //! Make a HTTP DELETE call. See Connection::del().
+    [[nodiscard]] inline answer_type del(const endpoint_variant &endpoint,
+                                         const parametermap &parameters = {})
+    {
+        return request(http_method::DELETE, endpoint, parameters);
+    }
+
+    //! @copydoc Connection::set_timeout
+    void set_timeout(milliseconds timeout);
+
+    /*!
+     *  @brief  Repeat requests that failed for reasons that may go away.
+     *
+     *  See Connection::set_retry_policy(). All Connection%s of the pool share
+     *  one RetryBudget.
+     *
+     *  @param  policy The retry_policy. Set retry_policy::max_attempts to 1
+     *                 to disable retries.
+     *
+     *  @since  0.6.0
+     */
+    void set_retry_policy(const retry_policy &policy);
+
+    /*!
+     *  @brief  Returns the statistics of the RetryBudget of the pool.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] retry_metrics get_retry_metrics();
+
+    //! @copydoc Connection::set_response_cache
+    void set_response_cache(shared_ptr<ResponseCache> cache);
+
+    //! @copydoc CURLWrapper::set_json_indexing
+    void set_json_indexing(bool enable);
+
+    /*!
+     *  @brief  Returns the number of Connection%s in the pool, busy or not.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] size_t get_connections();
+
+private:
+    struct Pooled;
+
+    const Instance &_instance;
+    const size_t _max_connections;
+    mutex _mutex;
+    condition_variable _available;
+    vector<unique_ptr<Pooled>> _idle;
+    size_t _connections{0};
+    //! Is increased with every change of the settings. Starts at 1, because
+    //! 0 means that a Connection was never configured.
+    uint64_t _generation{1};
+    milliseconds _timeout{0};
+    optional<retry_policy> _retry_policy;
+    shared_ptr<RetryBudget> _retry_budget;
+    shared_ptr<ResponseCache> _response_cache;
+    bool _json_indexing{false};
+
+    //! Take an idle Connection, make a new one or wait for one.
+    [[nodiscard]] unique_ptr<Pooled> borrow();
+
+    //! Put a Connection back into the pool.
+    void give_back(unique_ptr<Pooled> pooled);
+
+    //! Apply the settings to a Connection, if they have changed.
+    void configure(Pooled &pooled);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_SHARED_CONNECTION_HPP
@@ -0,0 +1,117 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_SINGLE_FLIGHT_HPP
+#define MASTODONPP_SINGLE_FLIGHT_HPP
+
+#include "types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::function;
+using std::mutex;
+using std::shared_future;
+using std::shared_ptr;
+using std::string;
+using std::uint64_t;
+using std::unordered_map;
+
+/*!
+ *  @brief  Statistics of a SingleFlight.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile single_flight.hpp mastodonpp/single_flight.hpp
+ */
+struct single_flight_metrics
+{
+    //! Requests that were sent.
+    uint64_t sent{0};
+
+    //! Requests that got the answer of an identical request.
+    uint64_t shared{0};
+};
+
+/*!
+ *  @brief  Lets identical requests that run at the same time share one
+ *          answer.
+ *
+ *  The first caller with a key makes the request. Everyone who calls with the
+ *  same key before it is finished waits for it and gets a copy of the answer.
+ *  Callers that come after it is finished make a new request.
+ *
+ *  Used by Connection for `GET` requests if Instance::set_request_coalescing()
+ *  is enabled. Requests are identical if the URI, including the parameters,
+ *  and the access token are the same.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile single_flight.hpp mastodonpp/single_flight.hpp
+ */
+class SingleFlight
+{
+public:
+    /*!
+     *  @brief  Returns the SingleFlight of the process.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static shared_ptr<SingleFlight> get();
+
+    /*!
+     *  @brief  Make a request, or wait for an identical one.
+     *
+     *  If @a request throws an exception, it is rethrown to all callers.
+     *
+     *  @param  key     Identifies the request.
+     *  @param  request Makes the request.
+     *
+     *  @return The answer.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] answer_type run(const string &key,
+                                  const function<answer_type()> &request);
+
+    /*!
+     *  @brief  Returns the statistics.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] single_flight_metrics get_metrics() const noexcept;
+
+private:
+    mutex _mutex;
+    //! The requests that are running.
+    unordered_map<string, shared_future<answer_type>> _running;
+    atomic<uint64_t> _sent{0};
+    atomic<uint64_t> _shared{0};
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_SINGLE_FLIGHT_HPP
@@ -0,0 +1,103 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_SSE_PARSER_HPP
+#define MASTODONPP_SSE_PARSER_HPP
+
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Incremental parser for [Server-Sent Events]
+ *          (https://html.spec.whatwg.org/multipage/server-sent-events.html).
+ *
+ *  Data can be fed in chunks of any size, as it arrives. Every byte is looked
+ *  at only once; incomplete lines are kept until the rest arrives. Multi-line
+ *  `data` fields, `id` fields and comments (used as heartbeats) are supported.
+ *
+ *  Used by Connection::get_new_events(). You don't need to use this.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile sse_parser.hpp mastodonpp/sse_parser.hpp
+ */
+class SSEParser
+{
+public:
+    /*!
+     *  @brief  Parse a chunk of data.
+     *
+     *  @param  data   The new data.
+     *  @param  events Complete events are appended to this.
+     *
+     *  @return The number of events that were appended.
+     *
+     *  @since  0.6.0
+     */
+    size_t feed(string_view data, vector<event_type> &events);
+
+    /*!
+     *  @brief  Forget everything, including incomplete lines and the last
+     *          event ID.
+     *
+     *  @since  0.6.0
+     */
+    void reset();
+
+    /*!
+     *  @brief  Returns the number of comments received since the last reset().
+     *
+     *  Mastodon sends a comment every few seconds to keep the connection open.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline size_t get_comments() const noexcept
+    {
+        return _comments;
+    }
+
+private:
+    string _line;
+    string _type;
+    string _data;
+    string _id;
+    bool _has_data{false};
+    bool _skip_lf{false};
+    size_t _comments{0};
+
+    /*!
+     *  @brief  Process a complete line, without the line ending.
+     *
+     *  @return true if an event was appended.
+     *
+     *  @since  0.6.0
+     */
+    bool process_line(string_view line, vector<event_type> &events);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_SSE_PARSER_HPP
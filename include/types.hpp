@@ -19,7 +19,11 @@
 #ifndef MASTODONPP_TYPES_HPP
 #define MASTODONPP_TYPES_HPP
 
+#include "json.hpp"
+
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <ostream>
 #include <string>
@@ -31,9 +35,12 @@
 namespace mastodonpp
 {
 
+using std::function;
+using std::int64_t;
 using std::map;
 using std::ostream;
 using std::pair;
+using std::size_t;
 using std::string;
 using std::string_view;
 using std::uint16_t;
@@ -41,12 +48,85 @@ using std::uint8_t;
 using std::variant;
 using std::vector;
 
+/*!
+ *  @brief  A file that is sent as part of a form, without copying it.
+ *
+ *  The data comes from exactly one of #data, #fd or #read. It is read while
+ *  the request is sent, so the source has to stay valid until it is
+ *  finished. Attachments are ignored in `GET` requests.
+ *
+ *  Example:
+ *  @code
+ *  std::string video{record_video()};
+ *  auto answer{connection.post(
+ *      mastodonpp::API::v2::media,
+ *      {{"file", mastodonpp::attachment{video, "cat.mp4", "video/mp4"}},
+ *       {"description", "A cat."}})};
+ *
+ *  mastodonpp::attachment picture;
+ *  picture.fd = open("cat.png", O_RDONLY);
+ *  picture.filename = "cat.png";
+ *  @endcode
+ *
+ *  @since  0.6.0
+ */
+struct attachment
+{
+    /*!
+     *  @brief  The data, if it is in memory.
+     *
+     *  May contain `NUL` bytes. Use this for `mmap`ed files too.
+     */
+    string_view data;
+
+    //! The filename that is sent to the server.
+    string_view filename;
+
+    /*!
+     *  @brief  The content type, like `image/png`.
+     *
+     *  If empty, libcurl guesses it from the extension of #filename.
+     */
+    string_view content_type;
+
+    /*!
+     *  @brief  The size in bytes, or -1.
+     *
+     *  Taken from #data or from the file behind #fd, if possible. If the size
+     *  is not known, the data is sent in chunks.
+     */
+    int64_t size{-1};
+
+    /*!
+     *  @brief  A file descriptor to read from, if not -1.
+     *
+     *  Reading starts at the current position of the file. It is not closed.
+     */
+    int fd{-1};
+
+    /*!
+     *  @brief  A function that fills @a buffer with up to @a size bytes.
+     *
+     *  Returns the number of bytes written and 0 at the end. Throwing an
+     *  exception aborts the request.
+     */
+    function<size_t(char *buffer, size_t size)> read;
+
+    /*!
+     *  @brief  A function that moves #read to @a offset from the start.
+     *
+     *  Needed to send the data again, after a redirect for example. Returns
+     *  false if that is not possible.
+     */
+    function<bool(int64_t offset)> seek;
+};
+
 /*!
  *  @brief  `std::map` of parameters for %API calls.
  *
  *  Note that arrays always have to be specified as vectors, even if they have
  *  only 1 element. To send a file, use “<tt>\@file:</tt>” followed by the file
- *  name as value.
+ *  name as value, or an attachment.
  *
  *  Example:
  *  @code
@@ -60,16 +140,16 @@ using std::vector;
  *
  *  @since  0.1.0
  */
-using parametermap = map<string_view,
-                         variant<string_view, vector<string_view>>>;
+using parametermap
+    = map<string_view, variant<string_view, vector<string_view>, attachment>>;
 
 /*!
  *  @brief  A single parameter of a parametermap.
  *
  *  @since  0.1.0
  */
-using parameterpair = pair<string_view,
-                           variant<string_view, vector<string_view>>>;
+using parameterpair
+    = pair<string_view, variant<string_view, vector<string_view>, attachment>>;
 
 /*!
  *  @brief  Return type for Request%s.
@@ -118,6 +198,16 @@ struct answer_type
      */
     string body;
 
+    /*!
+     *  @brief  The index of #body, if it is JSON.
+     *
+     *  Only filled if JSON indexing was enabled with
+     *  CURLWrapper::set_json_indexing().
+     *
+     *  @since  0.6.0
+     */
+    vector<json_node> json_index;
+
     /*!
      *  @brief  Returns true if #curl_error_code is 0 and #http_status is 200,
      *          false otherwise.
@@ -151,10 +241,24 @@ struct answer_type
      */
     [[nodiscard]] string_view get_header(string_view field) const;
 
+    /*!
+     *  @brief  Returns a view of the JSON in #body.
+     *
+     *  The value is invalid if #json_index is empty. Is only valid for as long
+     *  as the answer_type is in scope.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline JSONValue json() const
+    {
+        return JSONValue{body, json_index};
+    }
+
     /*!
      *  @brief  Returns the parameters needed for the next entries.
      *
-     *  Parses the `Link` header.
+     *  Parses the `Link` header. Returns an empty map if there are no next
+     *  entries.
      *
      *  @since  0.3.0
      */
@@ -166,7 +270,6 @@ struct answer_type
     /*!
      *  @brief  Returns the parameters needed for the previous entries.
      *
-     *
      *  Parses the `Link` header.
      *
      *  @since  0.3.0
@@ -180,7 +283,6 @@ private:
     /*!
      *  @brief  Returns the parameters needed for the next or previous entries.
      *
-     *
      *  Parses the `Link` header.
      *
      *  @since  0.3.0
@@ -188,6 +290,77 @@ private:
     [[nodiscard]] parametermap parse_pagination(bool next) const;
 };
 
+/*!
+ *  @brief  A stream event.
+ *
+ *  @since  0.1.0
+ *
+ *  @headerfile types.hpp mastodonpp/types.hpp
+ */
+struct event_type
+{
+    /*!
+     *  @brief  The type of the event.
+     *
+     *  Can be: “update”, “notification”, “delete” or “filters_changed”. For
+     *  more information consult [the Mastodon documentation]
+     *  (https://docs.joinmastodon.org/methods/timelines/streaming/
+     *  #event-types-a-idevent-typesa). Is “message” if the server did not send
+     *  a type.
+     */
+    string type;
+
+    //! The payload. Multiple `data` lines are joined with a newline.
+    string data;
+
+    /*!
+     *  @brief  The last event ID the server sent, if any.
+     *
+     *  @since  0.6.0
+     */
+    string id;
+};
+
+/*!
+ *  @brief  Function that is called with every stream event.
+ *
+ *  Return `false` to pause the stream. No more events are delivered until the
+ *  stream is resumed.
+ *
+ *  @since  0.6.0
+ */
+using event_callback = function<bool(event_type &&)>;
+
+/*!
+ *  @brief  The progress of a request, in bytes.
+ *
+ *  @since  0.6.0
+ */
+struct transfer_progress
+{
+    //! Bytes sent so far.
+    int64_t uploaded{0};
+
+    //! Bytes to send, or 0 if not known.
+    int64_t upload_total{0};
+
+    //! Bytes received so far.
+    int64_t downloaded{0};
+
+    //! Bytes to receive, or 0 if not known.
+    int64_t download_total{0};
+};
+
+/*!
+ *  @brief  Function that is called with the progress of a request.
+ *
+ *  Is called about once per second, and more often while data is sent or
+ *  received. Return `false` or throw an exception to abort the request.
+ *
+ *  @since  0.6.0
+ */
+using progress_callback = function<bool(const transfer_progress &)>;
+
 } // namespace mastodonpp
 
 #endif // MASTODONPP_TYPES_HPP
@@ -0,0 +1,131 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_URI_TEMPLATE_HPP
+#define MASTODONPP_URI_TEMPLATE_HPP
+
+#include "api.hpp"
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace mastodonpp
+{
+
+using std::string;
+using std::string_view;
+
+/*!
+ *  @brief  A URI with placeholders like `<ID>`, which are substituted with
+ *          parameters.
+ *
+ *  The positions of the placeholders are determined once, when the template
+ *  is constructed; for API endpoints at compile time. A placeholder is bound
+ *  to the parameter with the same name, case insensitive: `<ID>` is replaced
+ *  with the value of `id`. Every placeholder is replaced, even if the same
+ *  name appears more than once.
+ *
+ *  The template only refers to the strings it is constructed with, they have
+ *  to outlive it.
+ *
+ *  You don't need to use this.
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile uri_template.hpp mastodonpp/uri_template.hpp
+ */
+class URITemplate
+{
+public:
+    /*!
+     *  @brief  Construct a template from a base URI and a parsed path.
+     *
+     *  @param  baseuri For example `https://example.com`.
+     *  @param  path    For example `/api/v1/accounts/<ID>`.
+     *
+     *  @since  0.6.0
+     */
+    constexpr URITemplate(const string_view baseuri, const endpoint_path &path)
+        : _baseuri{baseuri}
+        , _path{path}
+    {}
+
+    /*!
+     *  @brief  Construct a template from a full URI, which is parsed now.
+     *
+     *  Throws `std::logic_error` if the URI is malformed, see endpoint_path.
+     *  Use literal() for URIs that are not yours.
+     *
+     *  @since  0.6.0
+     */
+    explicit constexpr URITemplate(const string_view uri)
+        : _path{uri}
+    {}
+
+    /*!
+     *  @brief  Construct a template from a full URI without placeholders.
+     *
+     *  The URI is used as it is, `<` and `>` have no special meaning. Use
+     *  this for URIs that come from servers.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static constexpr URITemplate literal(const string_view uri)
+    {
+        return {uri, endpoint_path{string_view{}}};
+    }
+
+    /*!
+     *  @brief  Write the URI, with all placeholders replaced, into @a uri.
+     *
+     *  The buffer is cleared and reserved for the exact size first.
+     *
+     *  @param  parameters The parameters to bind to the placeholders.
+     *  @param  uri        The buffer. Its capacity is kept.
+     *
+     *  @throw  CURLException with `CURLE_URL_MALFORMAT` if a placeholder is not
+     *          bound to a parameter with a single value.
+     *
+     *  @since  0.6.0
+     */
+    void render(const parametermap &parameters, string &uri) const;
+
+    /*!
+     *  @brief  Returns true if the parameter @a name is bound to a
+     *          placeholder.
+     *
+     *  Those parameters are not sent as query or form data.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] bool binds(string_view name) const noexcept;
+
+private:
+    string_view _baseuri;
+    endpoint_path _path;
+
+    /*!
+     *  @brief  Returns the name of the placeholder without `<` and `>`.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] string_view placeholder_name(size_t index) const noexcept;
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_URI_TEMPLATE_HPP
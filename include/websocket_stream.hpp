@@ -0,0 +1,316 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_WEBSOCKET_STREAM_HPP
+#define MASTODONPP_WEBSOCKET_STREAM_HPP
+
+#include "curl_wrapper.hpp"
+#include "instance.hpp"
+#include "json.hpp"
+#include "types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::map;
+using std::pair;
+using std::shared_ptr;
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::uint8_t;
+using std::chrono::milliseconds;
+
+/*!
+ *  @brief  Receives many streams over one WebSocket connection.
+ *
+ *  Uses the WebSocket endpoint of the [streaming API]
+ *  (https://docs.joinmastodon.org/methods/timelines/streaming/). Instead of
+ *  one connection per stream, all subscriptions share one socket. Every event
+ *  is routed to the callback of the stream it belongs to.
+ *
+ *  Requires libcurl 7.86.0 or newer, with WebSocket support enabled.
+ *
+ *  Example:
+ *  @code
+ *  mastodonpp::WebSocketStream ws{instance};
+ *  ws.subscribe("hashtag", "FediBlock", [](mastodonpp::event_type &&event)
+ *               {
+ *                   std::cout << event.type << ": " << event.data << '\n';
+ *                   return true;
+ *               });
+ *  ws.subscribe("user", {}, handle_user_event);
+ *  ws.connect();
+ *  while (ws.is_connected())
+ *  {
+ *      ws.poll(std::chrono::seconds(10));
+ *  }
+ *  @endcode
+ *
+ *  @since  0.6.0
+ *
+ *  @headerfile websocket_stream.hpp mastodonpp/websocket_stream.hpp
+ */
+class WebSocketStream : public CURLWrapper
+{
+public:
+    /*!
+     *  @brief  Construct a new WebSocketStream.
+     *
+     *  All properties of the Instance (proxy, access token, …) are used for
+     *  the connection. The access token is sent in the `Authorization` header
+     *  of the handshake.
+     *
+     *  @param  instance An Instance with the access data.
+     *
+     *  @since  0.6.0
+     */
+    explicit WebSocketStream(const Instance &instance);
+
+    //! Copy constructor
+    WebSocketStream(const WebSocketStream &other) = delete;
+
+    //! Move constructor
+    WebSocketStream(WebSocketStream &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Closes the connection.
+     *
+     *  @since  0.6.0
+     */
+    ~WebSocketStream() noexcept override;
+
+    //! Copy assignment operator
+    WebSocketStream &operator=(const WebSocketStream &other) = delete;
+
+    //! Move assignment operator
+    WebSocketStream &operator=(WebSocketStream &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Connect to `wss://` + hostname + `/api/v1/streaming`.
+     *
+     *  @copydetails connect(string_view)
+     */
+    answer_type connect();
+
+    /*!
+     *  @brief  Connect to a WebSocket URI.
+     *
+     *  Use this if the instance serves the streaming API from another host.
+     *  A connection that is already open is closed first. All subscriptions
+     *  are sent to the server after the handshake, so this can also be used
+     *  to reconnect after the connection was lost.
+     *
+     *  @param  uri A `ws://` or `wss://` URI.
+     *
+     *  @return The answer to the handshake. On success, @link
+     *          answer_type::http_status http_status @endlink is 101.
+     *
+     *  @since  0.6.0
+     */
+    answer_type connect(string_view uri);
+
+    /*!
+     *  @brief  Close the connection. The subscriptions are kept.
+     *
+     *  @since  0.6.0
+     */
+    void close();
+
+    /*!
+     *  @brief  Returns true if the connection is open.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] inline bool is_connected() const noexcept
+    {
+        return _connected;
+    }
+
+    /*!
+     *  @brief  Subscribe to a stream.
+     *
+     *  If the connection is open, the subscription is sent immediately,
+     *  otherwise after connect(). Subscribing to the same stream again replaces
+     *  the callback.
+     *
+     *  @param  stream    The name of the stream, for example “user”,
+     *                    “public:local” or “hashtag”.
+     *  @param  parameter The hashtag for “hashtag” and “hashtag:local”,
+     *                    the list ID for “list”, empty otherwise.
+     *  @param  callback  Is called with every event of this stream.
+     *                    event_type::data is the payload. Return `false` to
+     *                    unsubscribe.
+     *
+     *  @since  0.6.0
+     */
+    void subscribe(string_view stream, string_view parameter,
+                   event_callback callback);
+
+    /*!
+     *  @brief  Unsubscribe from a stream.
+     *
+     *  @param  stream    The name of the stream.
+     *  @param  parameter The hashtag or list ID, if any.
+     *
+     *  @since  0.6.0
+     */
+    void unsubscribe(string_view stream, string_view parameter = {});
+
+    /*!
+     *  @brief  Wait for messages and call the callbacks.
+     *
+     *  Waits until a message arrives or the timeout expires, then processes
+     *  all messages that are available without waiting. If the connection is
+     *  lost, is_connected() returns false afterwards.
+     *
+     *  @param  timeout The maximum time to wait for the first message.
+     *
+     *  @return The number of events that were delivered.
+     *
+     *  @since  0.6.0
+     */
+    size_t poll(milliseconds timeout);
+
+protected:
+    /*!
+     *  @brief  The type of a received WebSocket frame.
+     *
+     *  @since  0.6.0
+     */
+    enum class frame_type : uint8_t
+    {
+        //! A text or binary frame.
+        data,
+        //! A ping or pong, which libcurl answers by itself.
+        control,
+        //! The server closes the connection.
+        close
+    };
+
+    /*!
+     *  @brief  A received frame, or a part of it.
+     *
+     *  @since  0.6.0
+     */
+    struct frame_part
+    {
+        //! The number of bytes that were written into the buffer.
+        size_t size{0};
+        //! The type of the frame.
+        frame_type type{frame_type::data};
+        //! True if this is the end of the message.
+        bool last{true};
+    };
+
+    /*!
+     *  @brief  Do the WebSocket handshake.
+     *
+     *  The functions below exchange frames over the connection that was
+     *  opened by this one. Override all of them to use the WebSocketStream
+     *  without network, in tests for example. Such a subclass has to call
+     *  close() in its destructor.
+     *
+     *  @param  uri A `ws://` or `wss://` URI.
+     *
+     *  @return The answer to the handshake.
+     *
+     *  @since  0.6.0
+     */
+    virtual answer_type handshake(string_view uri);
+
+    /*!
+     *  @brief  Receive the next frame, or part of it, without waiting.
+     *
+     *  @return `CURLE_AGAIN` if nothing is available.
+     *
+     *  @since  0.6.0
+     */
+    virtual CURLcode receive(char *buffer, size_t size, frame_part &part);
+
+    /*!
+     *  @brief  Send a text frame, without waiting.
+     *
+     *  @param  text The text.
+     *  @param  sent Is set to the number of bytes sent.
+     *
+     *  @return `CURLE_AGAIN` if the socket is not ready.
+     *
+     *  @since  0.6.0
+     */
+    virtual CURLcode send_text(string_view text, size_t &sent);
+
+    /*!
+     *  @brief  Send a close frame.
+     *
+     *  @since  0.6.0
+     */
+    virtual void send_close();
+
+    /*!
+     *  @brief  Wait until the socket is readable or writable.
+     *
+     *  @return false if the timeout expired.
+     *
+     *  @since  0.6.0
+     */
+    virtual bool wait_for_socket(bool write, milliseconds timeout);
+
+private:
+    using stream_key = pair<string, string>;
+
+    const Instance &_instance;
+    bool _connected{false};
+    string _message;
+    JSONIndexer _indexer;
+    map<stream_key, shared_ptr<event_callback>> _subscriptions;
+
+    /*!
+     *  @brief  Send a subscribe or unsubscribe message.
+     *
+     *  @since  0.6.0
+     */
+    void send_subscription(string_view type, const stream_key &key);
+
+    /*!
+     *  @brief  Send a text message. Closes the connection on errors.
+     *
+     *  @since  0.6.0
+     */
+    void send(string_view text);
+
+    /*!
+     *  @brief  Route a complete message to its callback.
+     *
+     *  @return true if an event was delivered.
+     *
+     *  @since  0.6.0
+     */
+    bool dispatch(string_view message);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_WEBSOCKET_STREAM_HPP
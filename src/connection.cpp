@@ -16,95 +16,258 @@
 
 #include "connection.hpp"
 
+#include "exceptions.hpp"
+
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
 namespace mastodonpp
 {
 
 using std::holds_alternative;
+using std::make_shared;
+using std::move;
+using std::this_thread::sleep_until;
 
-string Connection::endpoint_to_uri(const endpoint_variant &endpoint) const
+URITemplate
+Connection::endpoint_to_template(const endpoint_variant &endpoint) const
 {
     if (holds_alternative<API::endpoint_type>(endpoint))
     {
-        return string(_baseuri) += API{std::get<API::endpoint_type>(endpoint)}
-                                       .to_string_view();
+        return {_baseuri,
+                API{std::get<API::endpoint_type>(endpoint)}.get_path()};
+    }
+
+    const auto path{std::get<string_view>(endpoint)};
+    try
+    {
+        return {_baseuri, endpoint_path{path}};
+    }
+    catch (const std::logic_error &e)
+    {
+        string message{e.what()};
+        (message += ' ') += path;
+        throw CURLException{CURLE_URL_MALFORMAT, message};
     }
-    return string(_baseuri) += std::get<string_view>(endpoint);
 }
 
 answer_type Connection::get(const endpoint_variant &endpoint,
                             const parametermap &parameters)
 {
-    return make_request(http_method::GET, endpoint_to_uri(endpoint),
-                        parameters);
+    return request(http_method::GET, endpoint, parameters);
 }
 
 answer_type Connection::post(const endpoint_variant &endpoint,
                              const parametermap &parameters)
 {
-    return make_request(http_method::POST, endpoint_to_uri(endpoint),
-                        parameters);
+    return request(http_method::POST, endpoint, parameters);
 }
 
 answer_type Connection::patch(const endpoint_variant &endpoint,
                               const parametermap &parameters)
 {
-    return make_request(http_method::PATCH, endpoint_to_uri(endpoint),
-                        parameters);
+    return request(http_method::PATCH, endpoint, parameters);
 }
 
 answer_type Connection::put(const endpoint_variant &endpoint,
                             const parametermap &parameters)
 {
-    return make_request(http_method::PUT, endpoint_to_uri(endpoint),
-                        parameters);
+    return request(http_method::PUT, endpoint, parameters);
 }
 
 answer_type Connection::del(const endpoint_variant &endpoint,
                             const parametermap &parameters)
 {
-    return make_request(http_method::DELETE, endpoint_to_uri(endpoint),
-                        parameters);
+    return request(http_method::DELETE, endpoint, parameters);
 }
 
-string Connection::get_new_stream_contents()
+answer_type Connection::stream(const endpoint_variant &endpoint,
+                               const parametermap &parameters,
+                               event_callback callback)
 {
-    _buffer_mutex.lock();
-    auto &buffer{get_buffer()};
-    string buffer_copy{buffer};
-    buffer.clear();
-    _buffer_mutex.unlock();
-    return buffer_copy;
+    set_event_callback(move(callback));
+    try
+    {
+        auto answer{make_request(http_method::GET,
+                                 endpoint_to_template(endpoint), parameters)};
+        set_event_callback({});
+        return answer;
+    }
+    catch (...)
+    {
+        set_event_callback({});
+        throw;
+    }
 }
 
-vector<event_type> Connection::get_new_events()
+answer_type Connection::request(const http_method &method,
+                                const endpoint_variant &endpoint,
+                                const parametermap &parameters)
 {
-    _buffer_mutex.lock();
-    auto &buffer{get_buffer()};
-    vector<event_type> events;
+    if (!_single_flight || method != http_method::GET)
+    {
+        return request_with_retries(method, endpoint, parameters);
+    }
+
+    // The URI, with the parameters, is only known after preparing.
+    prepare_request(method, endpoint_to_template(endpoint), parameters);
+    const auto key{
+        ResponseCache::make_key(get_uri(), _instance.get_access_token())};
+    return _single_flight->run(
+        key,
+        [this, &method, &endpoint, &parameters]
+        { return request_with_retries(method, endpoint, parameters); });
+}
+
+answer_type Connection::request_with_retries(const http_method &method,
+                                             const endpoint_variant &endpoint,
+                                             const parametermap &parameters)
+{
+    if (!_retry_budget)
+    {
+        return attempt(method, endpoint, parameters);
+    }
+
+    RetryState retry{_retry_policy, _retry_budget, method};
+    try
+    {
+        while (true)
+        {
+            limit_timeout(retry.time_left());
+            auto answer{attempt(method, endpoint, parameters)};
+            if (!retry.retry(answer))
+            {
+                limit_timeout(milliseconds{0});
+                return answer;
+            }
+            sleep_until(retry.next_attempt());
+        }
+    }
+    catch (...)
+    {
+        limit_timeout(milliseconds{0});
+        throw;
+    }
+}
+
+answer_type Connection::attempt(const http_method &method,
+                                const endpoint_variant &endpoint,
+                                const parametermap &parameters)
+{
+    prepare_request(method, endpoint_to_template(endpoint), parameters);
+
+    const bool use_cache{_response_cache && method == http_method::GET};
+    string key;
+    cache_entry entry;
+    bool cached{false};
+    if (use_cache)
+    {
+        key = ResponseCache::make_key(get_uri(), _instance.get_access_token());
+        cached = _response_cache->lookup(key, entry);
+        if (cached && entry.fresh())
+        {
+            return move(entry.answer);
+        }
+        if (cached)
+        {
+            set_request_headers(entry.conditional_headers());
+        }
+    }
 
-    size_t pos{0};
-    constexpr string_view search_event{"event: "};
-    while ((pos = buffer.find(search_event)) != string::npos)
+    answer_type answer;
+    if (_rate_limiter)
     {
-        const auto endpos{buffer.find("\n\n", pos)};
-        if (endpos == string::npos)
+        sleep_until(_rate_limiter->reserve());
+        try
+        {
+            answer = perform_request();
+        }
+        catch (...)
         {
-            break;
+            _rate_limiter->release({});
+            throw;
         }
+        _rate_limiter->release(answer);
+    }
+    else
+    {
+        answer = perform_request();
+    }
+
+    if (use_cache)
+    {
+        return _response_cache->update(key, move(answer),
+                                       cached ? &entry : nullptr);
+    }
+    return answer;
+}
+
+void Connection::set_timeout(const milliseconds timeout)
+{
+    _timeout = timeout;
+    limit_timeout(milliseconds{0});
+}
+
+void Connection::limit_timeout(const milliseconds time_left)
+{
+    auto timeout{_timeout};
+    if (time_left > milliseconds{0}
+        && (timeout <= milliseconds{0} || time_left < timeout))
+    {
+        timeout = time_left;
+    }
+
+    const long timeout_ms{timeout.count()}; // NOLINT(google-runtime-int)
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(get_curl_easy_handle(), CURLOPT_TIMEOUT_MS, timeout_ms);
+}
+
+void Connection::set_retry_policy(const retry_policy &policy)
+{
+    set_retry_policy(policy, nullptr);
+}
 
-        event_type event;
-        pos += search_event.size();
-        event.type = buffer.substr(pos, buffer.find('\n', pos) - pos);
-        constexpr string_view search_data{"data: "};
-        pos = buffer.find(search_data) + search_data.size();
-        event.data = buffer.substr(pos, endpos - pos);
-        events.push_back(event);
+void Connection::set_retry_policy(const retry_policy &policy,
+                                  shared_ptr<RetryBudget> budget)
+{
+    _retry_policy = policy;
+    if (policy.max_attempts > 1)
+    {
+        if (!budget)
+        {
+            budget = make_shared<RetryBudget>(policy);
+        }
+        _retry_budget = move(budget);
+    }
+    else
+    {
+        _retry_budget.reset();
+    }
+}
 
-        buffer.erase(0, endpos);
+retry_metrics Connection::get_retry_metrics() const
+{
+    if (!_retry_budget)
+    {
+        return {};
     }
+    return _retry_budget->get_metrics();
+}
 
+string Connection::get_new_stream_contents()
+{
+    // Swapping keeps the time in which the writer has to wait short.
+    string contents;
+    _buffer_mutex.lock();
+    contents.swap(get_buffer());
     _buffer_mutex.unlock();
-    return events;
+    return contents;
+}
+
+vector<event_type> Connection::get_new_events()
+{
+    return take_stream_events();
 }
 
 } // namespace mastodonpp
@@ -17,32 +17,185 @@
 #include "curl_wrapper.hpp"
 
 #include "exceptions.hpp"
+#include "handle_pool.hpp"
 #include "log.hpp"
+#include "spsc_queue.hpp"
 #include "version.hpp"
 
-#include <algorithm>
-#include <array>
 #include <atomic>
-#include <cctype>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace mastodonpp
 {
 
-using std::any_of;
-using std::array; // NOLINT(misc-unused-using-decls)
+using std::exchange;
 using std::atomic;
 using std::get;
+using std::lock_guard;
 using std::holds_alternative;
-using std::toupper;
-using std::transform;
+using std::make_unique;
+using std::move;
+using std::rethrow_exception;
 using std::uint16_t;
 using std::uint8_t;
 
 // No one will ever need more than 65535 connections. 😉
 static atomic<uint16_t> curlwrapper_instances{0};
 
-void CURLWrapper::init()
+// Mastodon sends a few events per second on busy timelines.
+constexpr size_t event_queue_capacity{1024};
+
+namespace
+{
+
+//! The state of an attachment while it is sent. Owned by libcurl.
+struct attachment_reader
+{
+    attachment source;
+    //! The position of the file descriptor when the form was built.
+    off_t start{0};
+    //! True if the file descriptor can be read with pread().
+    bool seekable{false};
+    int64_t position{0};
+};
+
+size_t read_attachment(char *buffer, const size_t size, const size_t nitems,
+                       void *arg)
+{
+    auto &reader{*static_cast<attachment_reader *>(arg)};
+    const auto &source{reader.source};
+    const size_t length{size * nitems};
+    size_t got{0};
+
+    try
+    {
+        if (source.read)
+        {
+            got = source.read(buffer, length);
+        }
+        else if (source.fd != -1)
+        {
+            const ssize_t result{
+                reader.seekable
+                    ? pread(source.fd, buffer, length,
+                            reader.start + reader.position)
+                    : ::read(source.fd, buffer, length)};
+            if (result < 0)
+            {
+                errorlog << "Could not read attachment: "
+                         << std::strerror(errno) << '\n';
+                return CURL_READFUNC_ABORT;
+            }
+            got = static_cast<size_t>(result);
+        }
+        else
+        {
+            const auto offset{static_cast<size_t>(reader.position)};
+            if (offset < source.data.size())
+            {
+                got = source.data.copy(buffer, length, offset);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        errorlog << "Could not read attachment: " << e.what() << '\n';
+        return CURL_READFUNC_ABORT;
+    }
+
+    reader.position += static_cast<int64_t>(got);
+    return got;
+}
+
+int seek_attachment(void *arg, const curl_off_t offset, const int origin)
+{
+    auto &reader{*static_cast<attachment_reader *>(arg)};
+    const auto &source{reader.source};
+    if (origin != SEEK_SET)
+    {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    if (source.read)
+    {
+        if (!source.seek)
+        {
+            return CURL_SEEKFUNC_CANTSEEK;
+        }
+        try
+        {
+            if (!source.seek(offset))
+            {
+                return CURL_SEEKFUNC_FAIL;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            return CURL_SEEKFUNC_FAIL;
+        }
+    }
+    else if (source.fd != -1 && !reader.seekable)
+    {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    reader.position = offset;
+    return CURL_SEEKFUNC_OK;
+}
+
+void free_attachment(void *arg)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    delete static_cast<attachment_reader *>(arg);
+}
+
+//! Returns true if a parameter is a file, which needs a multipart form.
+bool has_files(const parametermap &parameters)
+{
+    for (const auto &param : parameters)
+    {
+        if (holds_alternative<attachment>(param.second)
+            || (holds_alternative<string_view>(param.second)
+                && get<string_view>(param.second).substr(0, 6) == "@file:"))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//! Append @a text to @a out, percent-encoded.
+void append_urlencoded(string &out, const string_view text)
+{
+    constexpr string_view hex{"0123456789ABCDEF"};
+    for (const char c : text)
+    {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+            || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_'
+            || c == '~')
+        {
+            out += c;
+        }
+        else
+        {
+            const auto byte{static_cast<unsigned char>(c)};
+            out += '%';
+            out += hex[byte >> 4U];
+            out += hex[byte & 0x0FU]; // NOLINT(readability-magic-numbers)
+        }
+    }
+}
+
+} // namespace
+
+void CURLWrapper::init(const string_view hostname)
 {
     if (curlwrapper_instances == 0)
     {
@@ -51,23 +204,37 @@ void CURLWrapper::init()
     ++curlwrapper_instances;
     debuglog << "CURLWrapper instances: " << curlwrapper_instances << " (+1)\n";
 
-    _connection = curl_easy_init();
+    if (!_pool)
+    {
+        _pool = HandlePool::get(hostname);
+    }
+    _connection = _pool->borrow();
     setup_curl();
 }
 
 CURLWrapper::CURLWrapper()
 {
-    init();
+    init({});
 }
 
-CURLWrapper::CURLWrapper(const CURLWrapper &)
+CURLWrapper::CURLWrapper(const string_view hostname)
 {
-    init();
+    init(hostname);
+}
+
+CURLWrapper::CURLWrapper(const CURLWrapper &other)
+    : _pool{other._pool}
+{
+    init({});
 }
 
 CURLWrapper::~CURLWrapper() noexcept
 {
-    curl_easy_cleanup(_connection);
+    clear_request_headers();
+    clear_request_form();
+    // The pool has to be released before curl_global_cleanup() is called.
+    _pool->give_back(_connection);
+    _pool.reset();
 
     --curlwrapper_instances;
     debuglog << "CURLWrapper instances: " << curlwrapper_instances << " (-1)\n";
@@ -80,16 +247,45 @@ CURLWrapper::~CURLWrapper() noexcept
 answer_type CURLWrapper::make_request(const http_method &method, string uri,
                                       const parametermap &parameters)
 {
-    _stream_cancelled = false;
-    _curl_buffer_headers.clear();
-    _curl_buffer_body.clear();
+    return make_request(method, URITemplate::literal(uri), parameters);
+}
 
-    CURLcode code{CURLE_OK};
+answer_type CURLWrapper::make_request(const http_method &method,
+                                      const URITemplate &uri,
+                                      const parametermap &parameters)
+{
+    prepare_request(method, uri, parameters);
+    return perform_request();
+}
+
+answer_type CURLWrapper::perform_request()
+{
+    auto answer{finish_request(curl_easy_perform(_connection))};
+    if (_callback_exception)
+    {
+        rethrow_exception(exchange(_callback_exception, nullptr));
+    }
+
+    return answer;
+}
+
+void CURLWrapper::prepare_request(const http_method &method,
+                                  const URITemplate &uri,
+                                  const parametermap &parameters)
+{
+    uri.render(parameters, _uri);
+    reset_buffers();
+    clear_request_headers();
+    clear_request_form();
+
+    // Every request sets all options that depend on the method, so that
+    // nothing is left over from the last one.
+    const char *custom_request{nullptr};
     switch (method)
     {
     case http_method::GET:
     {
-        add_parameters_to_uri(uri, parameters);
+        add_parameters_to_uri(_uri, uri, parameters);
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
         curl_easy_setopt(_connection, CURLOPT_HTTPGET, 1L);
 
@@ -97,86 +293,55 @@ answer_type CURLWrapper::make_request(const http_method &method, string uri,
     }
     case http_method::POST:
     {
-        if (parameters.empty())
-        {
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-            curl_easy_setopt(_connection, CURLOPT_POST, 1L);
-        }
-        else
-        {
-            curl_mime *mime{parameters_to_curl_mime(uri, parameters)};
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-            curl_easy_setopt(_connection, CURLOPT_MIMEPOST, mime);
-        }
+        set_request_body(uri, parameters);
 
         break;
     }
     case http_method::PATCH:
     {
-        if (!parameters.empty())
-        {
-            curl_mime *mime{parameters_to_curl_mime(uri, parameters)};
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-            curl_easy_setopt(_connection, CURLOPT_MIMEPOST, mime);
-        }
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-        code = curl_easy_setopt(_connection, CURLOPT_CUSTOMREQUEST, "PATCH");
-        if (code != CURLE_OK)
-        {
-            throw CURLException{code, "Failed to set URI", _curl_buffer_error};
-        }
+        set_request_body(uri, parameters);
+        custom_request = "PATCH";
 
         break;
     }
     case http_method::PUT:
     {
-        if (!parameters.empty())
-        {
-            curl_mime *mime{parameters_to_curl_mime(uri, parameters)};
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-            curl_easy_setopt(_connection, CURLOPT_MIMEPOST, mime);
-        }
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-        code = curl_easy_setopt(_connection, CURLOPT_CUSTOMREQUEST, "PUT");
-        if (code != CURLE_OK)
-        {
-            throw CURLException{code, "Failed to set URI", _curl_buffer_error};
-        }
+        set_request_body(uri, parameters);
+        custom_request = "PUT";
 
         break;
     }
     case http_method::DELETE:
     {
-        if (!parameters.empty())
-        {
-            curl_mime *mime{parameters_to_curl_mime(uri, parameters)};
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-            curl_easy_setopt(_connection, CURLOPT_MIMEPOST, mime);
-        }
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-        code = curl_easy_setopt(_connection, CURLOPT_CUSTOMREQUEST, "DELETE");
-        if (code != CURLE_OK)
-        {
-            throw CURLException{code, "Failed to set URI", _curl_buffer_error};
-        }
+        set_request_body(uri, parameters);
+        custom_request = "DELETE";
 
         break;
     }
     }
-    debuglog << "Making request to: " << uri << '\n';
 
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-    code = curl_easy_setopt(_connection, CURLOPT_URL, uri.data());
+    CURLcode code{
+        curl_easy_setopt(_connection, CURLOPT_CUSTOMREQUEST, custom_request)};
+    if (code != CURLE_OK)
+    {
+        throw CURLException{code, "Failed to set HTTP method",
+                            _curl_buffer_error};
+    }
+
+    debuglog << "Making request to: " << _uri << '\n';
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    code = curl_easy_setopt(_connection, CURLOPT_URL, _uri.c_str());
     if (code != CURLE_OK)
     {
         throw CURLException{code, "Failed to set URI", _curl_buffer_error};
     }
+}
 
+answer_type CURLWrapper::finish_request(const CURLcode code)
+{
     answer_type answer;
-    code = curl_easy_perform(_connection);
     if (code == CURLE_OK
         || (code == CURLE_ABORTED_BY_CALLBACK && _stream_cancelled))
     {
@@ -186,8 +351,20 @@ answer_type CURLWrapper::make_request(const http_method &method, string uri,
         answer.http_status = static_cast<uint16_t>(http_status);
         debuglog << "HTTP status code: " << http_status << '\n';
 
-        answer.headers = _curl_buffer_headers;
-        answer.body = _curl_buffer_body;
+        // The buffers are cleared by the next request anyway, so we can move
+        // them into the answer instead of copying them.
+        answer.headers = move(_curl_buffer_headers);
+        _curl_buffer_headers.clear();
+        _buffer_mutex.lock();
+        answer.body = move(_curl_buffer_body);
+        _curl_buffer_body.clear();
+        // The body is incomplete if it was taken as stream.
+        if (_json_indexing && _json_indexer.size() == answer.body.size())
+        {
+            answer.json_index = _json_indexer.take_nodes();
+        }
+        _json_indexer.reset();
+        _buffer_mutex.unlock();
     }
     else
     {
@@ -200,6 +377,66 @@ answer_type CURLWrapper::make_request(const http_method &method, string uri,
     return answer;
 }
 
+void CURLWrapper::set_request_headers(const vector<string> &headers)
+{
+    clear_request_headers();
+    for (const auto &header : headers)
+    {
+        curl_slist *list{curl_slist_append(_request_headers, header.c_str())};
+        if (list == nullptr)
+        {
+            clear_request_headers();
+            throw CURLException{CURLE_OUT_OF_MEMORY,
+                                "Failed to add request header."};
+        }
+        _request_headers = list;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection, CURLOPT_HTTPHEADER, _request_headers);
+}
+
+void CURLWrapper::clear_request_headers()
+{
+    if (_request_headers == nullptr)
+    {
+        return;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(_request_headers);
+    _request_headers = nullptr;
+}
+
+void CURLWrapper::clear_request_form()
+{
+    if (_request_form == nullptr)
+    {
+        return;
+    }
+
+    // Detaches the form from the handle, too.
+    curl_mime_free(_request_form);
+    _request_form = nullptr;
+}
+
+void CURLWrapper::reset_buffers()
+{
+    _stream_cancelled = false;
+    _curl_buffer_headers.clear();
+    _buffer_mutex.lock();
+    _curl_buffer_body.clear();
+    _json_indexer.reset();
+    _parse_stream = false;
+    _sse_parser.reset();
+    _stream_events.clear();
+    _buffer_mutex.unlock();
+    _stream_events_delivered = 0;
+    _stream_paused = false;
+    _curl_paused = false;
+}
+
 void CURLWrapper::setup_connection_properties(const string_view proxy,
                                               const string_view access_token,
                                               const string_view cainfo,
@@ -226,6 +463,50 @@ void CURLWrapper::setup_connection_properties(const string_view proxy,
     }
 }
 
+vector<event_type> CURLWrapper::take_stream_events()
+{
+    if (!_parse_stream)
+    {
+        // The writer appends to the buffer until we switch it to the queue.
+        lock_guard<mutex> lock{_buffer_mutex};
+        if (!_parse_stream)
+        {
+            if (!_event_queue)
+            {
+                _event_queue = make_unique<SPSCQueue<event_type>>(
+                    event_queue_capacity);
+            }
+            _sse_parser.feed(_curl_buffer_body, _stream_events);
+            _curl_buffer_body.clear();
+            // Events that don't fit are moved by the writer later.
+            deliver_stream_events();
+            _parse_stream = true;
+        }
+    }
+
+    vector<event_type> events;
+    event_type event;
+    while (_event_queue->pop(event))
+    {
+        events.push_back(move(event));
+    }
+
+    return events;
+}
+
+void CURLWrapper::set_event_callback(event_callback callback)
+{
+    _event_callback = move(callback);
+}
+
+void CURLWrapper::set_body_buffer(string buffer)
+{
+    buffer.clear();
+    _buffer_mutex.lock();
+    _curl_buffer_body = move(buffer);
+    _buffer_mutex.unlock();
+}
+
 void CURLWrapper::set_proxy(const string_view proxy)
 {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
@@ -293,9 +574,37 @@ size_t CURLWrapper::writer_body(char *data, size_t size, size_t nmemb)
         return 0;
     }
 
-    _buffer_mutex.lock();
-    _curl_buffer_body.append(data, size * nmemb);
-    _buffer_mutex.unlock();
+    if (!_event_callback && !_parse_stream)
+    {
+        lock_guard<mutex> lock{_buffer_mutex};
+        if (!_parse_stream)
+        {
+            _curl_buffer_body.append(data, size * nmemb);
+            if (_json_indexing)
+            {
+                _json_indexer.feed({data, size * nmemb});
+            }
+            return size * nmemb;
+        }
+    }
+
+    // libcurl keeps the data and hands it to us again after unpausing.
+    if (_stream_paused || !deliver_stream_events())
+    {
+        if (_callback_exception)
+        {
+            return 0;
+        }
+        _curl_paused = true;
+        return CURL_WRITEFUNC_PAUSE;
+    }
+
+    _sse_parser.feed({data, size * nmemb}, _stream_events);
+    deliver_stream_events();
+    if (_callback_exception)
+    {
+        return 0;
+    }
 
     return size * nmemb;
 }
@@ -312,13 +621,80 @@ size_t CURLWrapper::writer_header(char *data, size_t size, size_t nmemb)
     return size * nmemb;
 }
 
-int CURLWrapper::progress(void *, curl_off_t, curl_off_t, curl_off_t,
-                          curl_off_t) const
+bool CURLWrapper::deliver_stream_events()
+{
+    while (_stream_events_delivered < _stream_events.size())
+    {
+        if (_stream_paused || _callback_exception)
+        {
+            return false;
+        }
+
+        auto &event{_stream_events[_stream_events_delivered]};
+        if (!_event_callback)
+        {
+            if (!_event_queue->push(move(event)))
+            {
+                return false;
+            }
+            ++_stream_events_delivered;
+            continue;
+        }
+
+        ++_stream_events_delivered;
+        try
+        {
+            if (!_event_callback(move(event)))
+            {
+                _stream_paused = true;
+            }
+        }
+        catch (...)
+        {
+            // Exceptions must not pass through libcurl.
+            _callback_exception = std::current_exception();
+            return false;
+        }
+    }
+    _stream_events.clear();
+    _stream_events_delivered = 0;
+
+    return true;
+}
+
+int CURLWrapper::progress(const curl_off_t dltotal, const curl_off_t dlnow,
+                          const curl_off_t ultotal, const curl_off_t ulnow)
 {
-    if (_stream_cancelled)
+    if (_stream_cancelled || _callback_exception)
     {
         return 1;
     }
+
+    if (_progress_callback)
+    {
+        try
+        {
+            if (!_progress_callback({ulnow, ultotal, dlnow, dltotal}))
+            {
+                return 1;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            errorlog << "Exception in progress callback: " << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if ((_event_callback || _parse_stream) && !_stream_paused)
+    {
+        if (deliver_stream_events() && _curl_paused)
+        {
+            _curl_paused = false;
+            curl_easy_pause(_connection, CURLPAUSE_CONT);
+        }
+    }
+
     return 0;
 }
 
@@ -363,52 +739,16 @@ void CURLWrapper::setup_curl()
     curl_easy_setopt(_connection, CURLOPT_MAXREDIRS, 10L);
 }
 
-bool CURLWrapper::replace_parameter_in_uri(string &uri,
-                                           const parameterpair &parameter)
-{
-    static constexpr array replace{"id",
-                                   "nickname",
-                                   "nickname_or_id",
-                                   "account_id",
-                                   "list_id",
-                                   "hashtag",
-                                   "permission_group",
-                                   "instance",
-                                   "report_id",
-                                   "name",
-                                   "emoji"};
-    if (any_of(replace.begin(), replace.end(),
-               [&parameter](const auto &s) { return s == parameter.first; }))
-    {
-        const string searchstring{[&parameter] {
-            string s{"<"};
-            s += parameter.first;
-            transform(s.begin(), s.end(), s.begin(),
-                      [](const unsigned char c) { return toupper(c); });
-            return s;
-        }()};
-        const auto pos{uri.find(searchstring)};
-        if (pos != string::npos)
-        {
-            uri.replace(pos, parameter.first.size() + 2,
-                        get<string_view>(parameter.second));
-            debuglog << "Replaced :" << parameter.first << " in URI with "
-                     << get<string_view>(parameter.second) << '\n';
-            return true;
-        }
-    }
-
-    return false;
-}
-
 void CURLWrapper::add_parameters_to_uri(string &uri,
+                                        const URITemplate &templ,
                                         const parametermap &parameters)
 {
     bool first{true};
     // Replace <ID> with the value of parameter “id” and so on.
     for (const auto &param : parameters)
     {
-        if (replace_parameter_in_uri(uri, param))
+        if (templ.binds(param.first)
+            || holds_alternative<attachment>(param.second))
         {
             continue;
         }
@@ -440,6 +780,71 @@ void CURLWrapper::add_parameters_to_uri(string &uri,
     }
 }
 
+void CURLWrapper::parameters_to_urlencoded(const URITemplate &templ,
+                                           const parametermap &parameters,
+                                           string &out)
+{
+    const auto append_pair{[&out](const string_view name,
+                                  const string_view suffix,
+                                  const string_view value)
+                           {
+                               if (!out.empty())
+                               {
+                                   out += '&';
+                               }
+                               append_urlencoded(out, name);
+                               append_urlencoded(out, suffix);
+                               out += '=';
+                               append_urlencoded(out, value);
+                           }};
+
+    for (const auto &param : parameters)
+    {
+        if (templ.binds(param.first))
+        {
+            continue;
+        }
+
+        if (holds_alternative<string_view>(param.second))
+        {
+            append_pair(param.first, {}, get<string_view>(param.second));
+        }
+        else if (holds_alternative<vector<string_view>>(param.second))
+        {
+            for (const auto &arg : get<vector<string_view>>(param.second))
+            {
+                append_pair(param.first, "[]", arg);
+            }
+        }
+    }
+}
+
+void CURLWrapper::set_request_body(const URITemplate &templ,
+                                   const parametermap &parameters)
+{
+    if (has_files(parameters))
+    {
+        // The form is freed before the next request or by the destructor.
+        _request_form = parameters_to_curl_mime(templ, parameters);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        curl_easy_setopt(_connection, CURLOPT_MIMEPOST, _request_form);
+        return;
+    }
+
+    // clear() keeps the memory, so the buffer rarely has to grow.
+    _request_body.clear();
+    parameters_to_urlencoded(templ, parameters, _request_body);
+    debuglog << "Form: " << _request_body << '\n';
+
+    // Without a size, libcurl would use strlen(). Without data, it would read
+    // the body from stdin.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(_request_body.size()));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(_connection, CURLOPT_POSTFIELDS, _request_body.c_str());
+}
+
 void CURLWrapper::add_mime_part(curl_mime *mime, string_view name,
                                 string_view data)
 {
@@ -449,7 +854,8 @@ void CURLWrapper::add_mime_part(curl_mime *mime, string_view name,
         throw CURLException{"Could not build HTTP form."};
     }
 
-    CURLcode code{curl_mime_name(part, name.data())};
+    // libcurl needs zero-terminated strings.
+    CURLcode code{curl_mime_name(part, string(name).c_str())};
     if (code != CURLE_OK)
     {
         throw CURLException{code, "Could not build HTTP form."};
@@ -457,12 +863,12 @@ void CURLWrapper::add_mime_part(curl_mime *mime, string_view name,
 
     if (data.substr(0, 6) == "@file:")
     {
-        const string_view filename{data.substr(6)};
-        code = curl_mime_filedata(part, filename.data());
+        const string filename{data.substr(6)};
+        code = curl_mime_filedata(part, filename.c_str());
     }
     else
     {
-        code = curl_mime_data(part, data.data(), CURL_ZERO_TERMINATED);
+        code = curl_mime_data(part, data.data(), data.size());
     }
     if (code != CURLE_OK)
     {
@@ -472,33 +878,105 @@ void CURLWrapper::add_mime_part(curl_mime *mime, string_view name,
     debuglog << "Set form part: " << name << " = " << data << '\n';
 }
 
-curl_mime *CURLWrapper::parameters_to_curl_mime(string &uri,
+void CURLWrapper::add_mime_part(curl_mime *mime, string_view name,
+                                const attachment &file)
+{
+    curl_mimepart *part{curl_mime_addpart(mime)};
+    if (part == nullptr)
+    {
+        throw CURLException{"Could not build HTTP form."};
+    }
+
+    CURLcode code{curl_mime_name(part, string(name).c_str())};
+    if (code == CURLE_OK && !file.filename.empty())
+    {
+        code = curl_mime_filename(part, string(file.filename).c_str());
+    }
+    if (code == CURLE_OK && !file.content_type.empty())
+    {
+        code = curl_mime_type(part, string(file.content_type).c_str());
+    }
+    if (code != CURLE_OK)
+    {
+        throw CURLException{code, "Could not build HTTP form."};
+    }
+
+    auto reader{make_unique<attachment_reader>()};
+    reader->source = file;
+    int64_t size{file.size};
+    if (!file.read && file.fd != -1)
+    {
+        reader->start = lseek(file.fd, 0, SEEK_CUR);
+        reader->seekable = reader->start != -1;
+        struct stat status
+        {};
+        if (size < 0 && reader->seekable && fstat(file.fd, &status) == 0
+            && S_ISREG(status.st_mode)) // NOLINT(hicpp-signed-bitwise)
+        {
+            size = status.st_size - reader->start;
+        }
+    }
+    else if (!file.read && size < 0)
+    {
+        size = static_cast<int64_t>(file.data.size());
+    }
+
+    code = curl_mime_data_cb(part, size, read_attachment, seek_attachment,
+                             free_attachment, reader.get());
+    if (code != CURLE_OK)
+    {
+        throw CURLException{code, "Could not build HTTP form."};
+    }
+    // The part owns the reader now.
+    reader.release();
+
+    debuglog << "Set form part: " << name << " = <" << size << " bytes>\n";
+}
+
+curl_mime *CURLWrapper::parameters_to_curl_mime(const URITemplate &templ,
                                                 const parametermap &parameters)
 {
     debuglog << "Building HTTP form.\n";
 
     curl_mime *mime{curl_mime_init(_connection)};
+    if (mime == nullptr)
+    {
+        throw CURLException{CURLE_OUT_OF_MEMORY, "Could not build HTTP form."};
+    }
 
-    for (const auto &param : parameters)
+    try
     {
-        if (replace_parameter_in_uri(uri, param))
+        for (const auto &param : parameters)
         {
-            continue;
-        }
+            if (templ.binds(param.first))
+            {
+                continue;
+            }
 
-        if (holds_alternative<string_view>(param.second))
-        {
-            add_mime_part(mime, param.first, get<string_view>(param.second));
-        }
-        else
-        {
-            for (const auto &arg : get<vector<string_view>>(param.second))
+            if (holds_alternative<string_view>(param.second))
+            {
+                add_mime_part(mime, param.first,
+                              get<string_view>(param.second));
+            }
+            else if (holds_alternative<attachment>(param.second))
             {
-                const string_view name{string(param.first) += "[]"};
-                add_mime_part(mime, name, arg);
+                add_mime_part(mime, param.first, get<attachment>(param.second));
+            }
+            else
+            {
+                const string name{string(param.first) += "[]"};
+                for (const auto &arg : get<vector<string_view>>(param.second))
+                {
+                    add_mime_part(mime, name, arg);
+                }
             }
         }
     }
+    catch (const CURLException &)
+    {
+        curl_mime_free(mime);
+        throw;
+    }
 
     return mime;
 }
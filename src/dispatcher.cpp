@@ -0,0 +1,449 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dispatcher.hpp"
+
+#include "exceptions.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::exception;
+using std::max;
+using std::min;
+using std::chrono::ceil;
+using std::chrono::steady_clock;
+using std::lock_guard;
+using std::make_shared;
+using std::make_unique;
+using std::move;
+using std::promise;
+
+//! A Connection that can be driven by the Dispatcher.
+class Dispatcher::Transfer : public Connection
+{
+public:
+    explicit Transfer(const Instance &instance)
+        : Connection{instance}
+    {}
+
+    void prepare(const http_method &method, const endpoint_variant &endpoint,
+                 const parametermap &parameters)
+    {
+        prepare_request(method, endpoint_to_template(endpoint), parameters);
+    }
+
+    [[nodiscard]] answer_type finish(const CURLcode code)
+    {
+        return finish_request(code);
+    }
+
+    //! Get ready to perform the prepared request again.
+    void restart()
+    {
+        reset_buffers();
+    }
+
+    using Connection::limit_timeout;
+};
+
+//! A queued or running request.
+struct Dispatcher::Request
+{
+    unique_ptr<Transfer> transfer;
+    answer_callback callback;
+    //! When the RateLimiter allows the request to start.
+    steady_clock::time_point start;
+    //! The attempts so far, if retries are enabled.
+    unique_ptr<RetryState> retry;
+};
+
+namespace
+{
+
+answer_type aborted_answer()
+{
+    answer_type answer;
+    answer.curl_error_code = CURLE_ABORTED_BY_CALLBACK;
+    answer.error_message = "The Dispatcher was destroyed.";
+    return answer;
+}
+
+void call_back(const answer_callback &callback, answer_type answer) noexcept
+{
+    try
+    {
+        callback(move(answer));
+    }
+    catch (const exception &e)
+    {
+        errorlog << "Exception in callback: " << e.what() << '\n';
+    }
+}
+
+} // namespace
+
+Dispatcher::Dispatcher(const Instance &instance)
+    : _instance{instance}
+    , _multi{curl_multi_init()}
+    , _rate_limiter{instance.get_rate_limiter()}
+{
+    if (_multi == nullptr)
+    {
+        throw CURLException{CURLE_FAILED_INIT,
+                            "Failed to initialize curl multi handle."};
+    }
+
+    _loop = thread{&Dispatcher::run, this};
+}
+
+Dispatcher::~Dispatcher() noexcept
+{
+    _stop = true;
+    wakeup();
+    _loop.join();
+
+    const auto abort_request{[this](const Request &request)
+                     {
+                         if (_rate_limiter)
+                         {
+                             _rate_limiter->release({});
+                         }
+                         call_back(request.callback, aborted_answer());
+                     }};
+    for (auto &running : _running)
+    {
+        curl_multi_remove_handle(_multi, running.first);
+        abort_request(*running.second);
+    }
+    for (auto &request : _pending)
+    {
+        abort_request(*request);
+    }
+    for (auto &request : _waiting)
+    {
+        abort_request(*request);
+    }
+    _running.clear();
+    _pending.clear();
+    _waiting.clear();
+
+    curl_multi_cleanup(_multi);
+}
+
+future<answer_type> Dispatcher::submit(const http_method &method,
+                                       const endpoint_variant &endpoint,
+                                       const parametermap &parameters)
+{
+    auto answer_promise{make_shared<promise<answer_type>>()};
+    auto answer_future{answer_promise->get_future()};
+
+    submit(method, endpoint, parameters,
+           [answer_promise](answer_type answer)
+           { answer_promise->set_value(move(answer)); });
+
+    return answer_future;
+}
+
+void Dispatcher::submit(const http_method &method,
+                        const endpoint_variant &endpoint,
+                        const parametermap &parameters,
+                        answer_callback callback)
+{
+    enqueue(method, endpoint, parameters, move(callback), {}, milliseconds{0});
+}
+
+void Dispatcher::submit(const http_method &method,
+                        const endpoint_variant &endpoint,
+                        const parametermap &parameters,
+                        answer_callback callback, progress_callback progress)
+{
+    enqueue(method, endpoint, parameters, move(callback), move(progress),
+            milliseconds{0});
+}
+
+void Dispatcher::submit_after(const milliseconds delay,
+                              const http_method &method,
+                              const endpoint_variant &endpoint,
+                              const parametermap &parameters,
+                              answer_callback callback)
+{
+    enqueue(method, endpoint, parameters, move(callback), {}, delay);
+}
+
+void Dispatcher::enqueue(const http_method &method,
+                         const endpoint_variant &endpoint,
+                         const parametermap &parameters,
+                         answer_callback callback, progress_callback progress,
+                         const milliseconds delay)
+{
+    auto request{make_unique<Request>()};
+    request->transfer = get_transfer();
+    try
+    {
+        request->transfer->prepare(method, endpoint, parameters);
+    }
+    catch (const CURLException &)
+    {
+        release_transfer(move(request->transfer));
+        throw;
+    }
+    request->transfer->set_progress_callback(move(progress));
+    request->callback = move(callback);
+    request->start = steady_clock::now() + delay;
+    {
+        lock_guard<mutex> lock{_mutex};
+        request->transfer->set_timeout(_timeout);
+        if (_retry_budget)
+        {
+            request->retry = make_unique<RetryState>(_retry_policy,
+                                                     _retry_budget, method);
+        }
+    }
+    if (_rate_limiter)
+    {
+        request->start = max(request->start, _rate_limiter->reserve());
+    }
+
+    ++_active_requests;
+    {
+        lock_guard<mutex> lock{_mutex};
+        _pending.push_back(move(request));
+    }
+    wakeup();
+}
+
+void Dispatcher::set_max_connections(const long max) // NOLINT
+{
+    // The multi handle may only be touched by the event loop.
+    _max_connections = max;
+    wakeup();
+}
+
+void Dispatcher::set_timeout(const milliseconds timeout)
+{
+    lock_guard<mutex> lock{_mutex};
+    _timeout = timeout;
+}
+
+void Dispatcher::set_retry_policy(const retry_policy &policy)
+{
+    lock_guard<mutex> lock{_mutex};
+    _retry_policy = policy;
+    if (policy.max_attempts > 1)
+    {
+        _retry_budget = make_shared<RetryBudget>(policy);
+    }
+    else
+    {
+        _retry_budget.reset();
+    }
+}
+
+retry_metrics Dispatcher::get_retry_metrics()
+{
+    lock_guard<mutex> lock{_mutex};
+    if (!_retry_budget)
+    {
+        return {};
+    }
+    return _retry_budget->get_metrics();
+}
+
+void Dispatcher::run()
+{
+    constexpr milliseconds max_timeout{1000};
+    int still_running{0};
+    while (!_stop)
+    {
+        const auto timeout{min(add_pending(), max_timeout)};
+
+        const CURLMcode code{curl_multi_perform(_multi, &still_running)};
+        if (code != CURLM_OK)
+        {
+            errorlog << "curl_multi_perform() failed: "
+                     << curl_multi_strerror(code) << '\n';
+        }
+
+        process_finished();
+
+#if (LIBCURL_VERSION_NUM >= 0x074400) // libcurl >= 7.68.0.
+        curl_multi_poll(_multi, nullptr, 0, static_cast<int>(timeout.count()),
+                        nullptr);
+#else
+        constexpr milliseconds max_wait{100};
+        curl_multi_wait(_multi, nullptr, 0,
+                        static_cast<int>(min(timeout, max_wait).count()),
+                        nullptr);
+#endif
+    }
+}
+
+milliseconds Dispatcher::add_pending()
+{
+    const auto max_connections{_max_connections.exchange(-1)};
+    if (max_connections >= 0)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        curl_multi_setopt(_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                          max_connections);
+        debuglog << "Set maximum connections to " << max_connections << '\n';
+    }
+
+    {
+        lock_guard<mutex> lock{_mutex};
+        for (auto &request : _pending)
+        {
+            _waiting.push_back(move(request));
+        }
+        _pending.clear();
+    }
+
+    // Requests are started in the order the RateLimiter allows them.
+    const auto now{steady_clock::now()};
+    auto next_start{steady_clock::time_point::max()};
+    vector<unique_ptr<Request>> ready;
+    auto it{_waiting.begin()};
+    while (it != _waiting.end())
+    {
+        if ((*it)->start > now)
+        {
+            next_start = min(next_start, (*it)->start);
+            ++it;
+            continue;
+        }
+        ready.push_back(move(*it));
+        it = _waiting.erase(it);
+    }
+
+    for (auto &request : ready)
+    {
+        request->transfer->limit_timeout(request->retry
+                                             ? request->retry->time_left()
+                                             : milliseconds{0});
+        CURL *handle{request->transfer->get_curl_easy_handle()};
+        const CURLMcode code{curl_multi_add_handle(_multi, handle)};
+        if (code != CURLM_OK)
+        {
+            errorlog << "curl_multi_add_handle() failed: "
+                     << curl_multi_strerror(code) << '\n';
+            auto answer{request->transfer->finish(CURLE_FAILED_INIT)};
+            release_transfer(move(request->transfer));
+            if (_rate_limiter)
+            {
+                _rate_limiter->release(answer);
+            }
+            --_active_requests;
+            call_back(request->callback, move(answer));
+            continue;
+        }
+        _running.emplace(handle, move(request));
+    }
+
+    if (next_start == steady_clock::time_point::max())
+    {
+        return milliseconds::max();
+    }
+    return ceil<milliseconds>(next_start - now);
+}
+
+void Dispatcher::process_finished()
+{
+    int msgs_left{0};
+    CURLMsg *msg{nullptr};
+    while ((msg = curl_multi_info_read(_multi, &msgs_left)) != nullptr)
+    {
+        if (msg->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        CURL *handle{msg->easy_handle};
+        const CURLcode result{msg->data.result};
+        curl_multi_remove_handle(_multi, handle);
+
+        const auto it{_running.find(handle)};
+        if (it == _running.end())
+        {
+            errorlog << "Finished transfer is unknown.\n";
+            continue;
+        }
+        auto request{move(it->second)};
+        _running.erase(it);
+
+        auto answer{request->transfer->finish(result)};
+        if (_rate_limiter)
+        {
+            _rate_limiter->release(answer);
+        }
+
+        if (request->retry && request->retry->retry(answer))
+        {
+            request->transfer->restart();
+            request->start = request->retry->next_attempt();
+            if (_rate_limiter)
+            {
+                request->start = max(request->start,
+                                     _rate_limiter->reserve());
+            }
+            _waiting.push_back(move(request));
+            // Let add_pending() calculate the timeout again.
+            wakeup();
+            continue;
+        }
+
+        release_transfer(move(request->transfer));
+        --_active_requests;
+        call_back(request->callback, move(answer));
+    }
+}
+
+void Dispatcher::wakeup()
+{
+#if (LIBCURL_VERSION_NUM >= 0x074400) // libcurl >= 7.68.0.
+    curl_multi_wakeup(_multi);
+#endif
+}
+
+unique_ptr<Dispatcher::Transfer> Dispatcher::get_transfer()
+{
+    {
+        lock_guard<mutex> lock{_mutex};
+        if (!_idle.empty())
+        {
+            auto transfer{move(_idle.back())};
+            _idle.pop_back();
+            return transfer;
+        }
+    }
+
+    debuglog << "Creating new transfer.\n";
+    return make_unique<Transfer>(_instance);
+}
+
+void Dispatcher::release_transfer(unique_ptr<Transfer> transfer)
+{
+    transfer->set_progress_callback({});
+    lock_guard<mutex> lock{_mutex};
+    _idle.push_back(move(transfer));
+}
+
+} // namespace mastodonpp
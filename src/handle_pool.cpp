@@ -0,0 +1,161 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handle_pool.hpp"
+
+#include "exceptions.hpp"
+#include "log.hpp"
+
+#include <map>
+
+namespace mastodonpp
+{
+
+using std::less;
+using std::lock_guard;
+using std::make_shared;
+using std::map;
+using std::weak_ptr;
+
+// Idle handles above this number are cleaned up.
+constexpr size_t max_idle_handles{16};
+
+shared_ptr<HandlePool> HandlePool::get(const string_view hostname)
+{
+    static mutex registry_mutex;
+    static map<string, weak_ptr<HandlePool>, less<>> registry;
+
+    lock_guard<mutex> lock{registry_mutex};
+    const auto it{registry.find(hostname)};
+    if (it != registry.end())
+    {
+        if (auto pool{it->second.lock()})
+        {
+            return pool;
+        }
+        registry.erase(it);
+    }
+
+    auto pool{make_shared<HandlePool>(hostname)};
+    registry.emplace(hostname, pool);
+    return pool;
+}
+
+HandlePool::HandlePool(const string_view hostname)
+    : _hostname{hostname}
+    , _share{curl_share_init()}
+{
+    if (_share == nullptr)
+    {
+        throw CURLException{CURLE_FAILED_INIT,
+                            "Failed to initialize curl share handle."};
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, lock);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, unlock);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // The connection cache is not shared: the handles are used by many
+    // threads at once, and libcurl does not support that for connections.
+    // Every handle keeps its own connections instead, and they stay open
+    // while the handle waits in the pool.
+
+    debuglog << "Created handle pool for \"" << _hostname << "\".\n";
+}
+
+HandlePool::~HandlePool() noexcept
+{
+    // The handles have to be detached before the share can be cleaned up.
+    for (CURL *handle : _idle)
+    {
+        curl_easy_cleanup(handle);
+    }
+    curl_share_cleanup(_share);
+
+    debuglog << "Destroyed handle pool for \"" << _hostname << "\".\n";
+}
+
+CURL *HandlePool::borrow()
+{
+    CURL *handle{nullptr};
+    {
+        lock_guard<mutex> lock{_idle_mutex};
+        if (!_idle.empty())
+        {
+            handle = _idle.back();
+            _idle.pop_back();
+        }
+    }
+
+    if (handle == nullptr)
+    {
+        handle = curl_easy_init();
+        if (handle == nullptr)
+        {
+            throw CURLException{CURLE_FAILED_INIT,
+                                "Failed to initialize curl."};
+        }
+        debuglog << "Created new handle for \"" << _hostname << "\".\n";
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_setopt(handle, CURLOPT_SHARE, _share);
+
+    return handle;
+}
+
+void HandlePool::give_back(CURL *handle) noexcept
+{
+    if (handle == nullptr)
+    {
+        return;
+    }
+
+    curl_easy_reset(handle);
+
+    {
+        lock_guard<mutex> lock{_idle_mutex};
+        if (_idle.size() < max_idle_handles)
+        {
+            _idle.push_back(handle);
+            return;
+        }
+    }
+
+    curl_easy_cleanup(handle);
+}
+
+void HandlePool::lock(CURL *, const curl_lock_data data, curl_lock_access,
+                      void *userptr)
+{
+    auto &mutexes{static_cast<HandlePool *>(userptr)->_share_mutexes};
+    mutexes.at(static_cast<size_t>(data)).lock();
+}
+
+void HandlePool::unlock(CURL *, const curl_lock_data data, void *userptr)
+{
+    auto &mutexes{static_cast<HandlePool *>(userptr)->_share_mutexes};
+    mutexes.at(static_cast<size_t>(data)).unlock();
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,113 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_HANDLE_POOL_HPP
+#define MASTODONPP_HANDLE_POOL_HPP
+
+#include <curl/curl.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::array;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+using std::vector;
+
+/*!
+ *  @brief  Keeps idle CURL easy handles of one host for reuse.
+ *
+ *  All handles of a pool are attached to the same share handle, which holds
+ *  the DNS cache and the TLS session cache. The connection cache is not
+ *  shared, because the handles are used by different threads at the same
+ *  time. Every handle keeps its own connections, and they stay open while it
+ *  is idle, so a handle that is borrowed from the pool can reuse the
+ *  connections it opened before.
+ *
+ *  There is one pool per host. It lives as long as a CURLWrapper uses it.
+ *
+ *  @since  0.6.0
+ */
+class HandlePool
+{
+public:
+    /*!
+     *  @brief  Returns the pool for a host, creating it if necessary.
+     *
+     *  @param  hostname The hostname, or an empty string for the default pool.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] static shared_ptr<HandlePool> get(string_view hostname);
+
+    //! Constructs a pool. Use get() instead.
+    explicit HandlePool(string_view hostname);
+
+    //! Copy constructor
+    HandlePool(const HandlePool &other) = delete;
+
+    //! Move constructor
+    HandlePool(HandlePool &&other) noexcept = delete;
+
+    //! Cleans up the idle handles and the share handle.
+    ~HandlePool() noexcept;
+
+    //! Copy assignment operator
+    HandlePool &operator=(const HandlePool &other) = delete;
+
+    //! Move assignment operator
+    HandlePool &operator=(HandlePool &&other) noexcept = delete;
+
+    /*!
+     *  @brief  Returns an idle handle or creates a new one.
+     *
+     *  @since  0.6.0
+     */
+    [[nodiscard]] CURL *borrow();
+
+    /*!
+     *  @brief  Resets the handle and puts it back into the pool.
+     *
+     *  Live connections and caches of the handle are kept.
+     *
+     *  @since  0.6.0
+     */
+    void give_back(CURL *handle) noexcept;
+
+private:
+    const string _hostname;
+    CURLSH *_share{nullptr};
+    array<mutex, CURL_LOCK_DATA_LAST> _share_mutexes;
+    mutex _idle_mutex;
+    vector<CURL *> _idle;
+
+    static void lock(CURL *handle, curl_lock_data data,
+                     curl_lock_access access, void *userptr);
+    static void unlock(CURL *handle, curl_lock_data data, void *userptr);
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_HANDLE_POOL_HPP
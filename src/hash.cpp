@@ -0,0 +1,48 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hash.hpp"
+
+#include <cstdint>
+
+namespace mastodonpp
+{
+
+using std::uint64_t;
+
+string hash_hex(const string_view text)
+{
+    // NOLINTBEGIN(readability-magic-numbers)
+    uint64_t hash{0xcbf29ce484222325};
+    for (const char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+
+    constexpr string_view digits{"0123456789abcdef"};
+    string hex(16, '0');
+    for (auto it{hex.rbegin()}; it != hex.rend(); ++it)
+    {
+        *it = digits[hash & 0xfU];
+        hash >>= 4U;
+    }
+    // NOLINTEND(readability-magic-numbers)
+
+    return hex;
+}
+
+} // namespace mastodonpp
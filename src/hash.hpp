@@ -0,0 +1,40 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_HASH_HPP
+#define MASTODONPP_HASH_HPP
+
+#include <string>
+#include <string_view>
+
+namespace mastodonpp
+{
+
+using std::string;
+using std::string_view;
+
+/*!
+ *  @brief  64 bit FNV-1a hash as 16 hexadecimal digits. Stable across runs.
+ *
+ *  Used to keep access tokens out of keys and file names.
+ *
+ *  @since  0.6.0
+ */
+[[nodiscard]] string hash_hex(string_view text);
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_HASH_HPP
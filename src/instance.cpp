@@ -16,24 +16,27 @@
 
 #include "instance.hpp"
 
+#include "json.hpp"
 #include "log.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <exception>
-#include <regex>
+#include <system_error>
+#include <utility>
 
 namespace mastodonpp
 {
 
+using std::errc;
 using std::exception;
-using std::regex;
-using std::regex_search;
-using std::smatch;
+using std::from_chars;
+using std::move;
 using std::sort;
-using std::stoull;
 
 Instance::Instance(const string_view hostname, const string_view access_token)
-    : _hostname{hostname}
+    : CURLWrapper{hostname}
+    , _hostname{hostname}
     , _baseuri{"https://" + _hostname}
     , _max_chars{0}
 {
@@ -50,6 +53,8 @@ Instance::Instance(const Instance &other)
     , _post_formats{other._post_formats}
     , _cainfo{other._cainfo}
     , _useragent{other._useragent}
+    , _rate_limiting{other._rate_limiting}
+    , _request_coalescing{other._request_coalescing}
 {
     CURLWrapper::setup_connection_properties(_proxy, _access_token, _cainfo,
                                              _useragent);
@@ -67,8 +72,7 @@ uint64_t Instance::get_max_chars() noexcept
     try
     {
         debuglog << "Querying " << _hostname << " for max_toot_chars…\n";
-        const auto answer{
-            make_request(http_method::GET, _baseuri + "/api/v1/instance", {})};
+        const auto answer{get_instance_info()};
         if (!answer)
         {
             debuglog << "Could not get instance info.\n";
@@ -79,12 +83,20 @@ uint64_t Instance::get_max_chars() noexcept
         _max_chars = [&answer]
         {
             // clang-format on
-            const regex re_chars{R"("max_toot_chars"\s*:\s*([^"]+))"};
-            smatch match;
+            auto value{json_extract(answer.body, "max_toot_chars")};
+            if (value.empty())
+            {
+                value = json_extract(answer.body,
+                                     "configuration.statuses.max_characters");
+            }
 
-            if (regex_search(answer.body, match, re_chars))
+            uint64_t max_chars{0};
+            const auto result{from_chars(value.data(),
+                                         value.data() + value.size(),
+                                         max_chars)};
+            if (result.ec == errc{} && max_chars != 0)
             {
-                return static_cast<uint64_t>(stoull(match[1].str()));
+                return max_chars;
             }
 
             debuglog << "max_toot_chars not found.\n";
@@ -101,7 +113,56 @@ uint64_t Instance::get_max_chars() noexcept
     return _max_chars;
 }
 
+answer_type Instance::get_instance_info()
+{
+    return get_metadata("instance",
+                        [this]
+                        {
+                            return make_request(http_method::GET,
+                                                _baseuri + "/api/v1/instance",
+                                                {});
+                        });
+}
+
+answer_type Instance::get_custom_emojis()
+{
+    return get_metadata("custom_emojis",
+                        [this]
+                        {
+                            return make_request(http_method::GET,
+                                                _baseuri
+                                                    + "/api/v1/custom_emojis",
+                                                {});
+                        });
+}
+
 answer_type Instance::get_nodeinfo()
+{
+    return get_metadata("nodeinfo", [this] { return download_nodeinfo(); });
+}
+
+answer_type Instance::get_metadata(const string_view field,
+                                   const function<answer_type()> &download)
+{
+    constexpr uint16_t http_ok{200};
+
+    const auto registry{InstanceRegistry::get()};
+    answer_type answer;
+    if (registry->lookup(_hostname, field, answer.body))
+    {
+        answer.http_status = http_ok;
+        return answer;
+    }
+
+    answer = download();
+    if (answer)
+    {
+        registry->store(_hostname, field, answer.body);
+    }
+    return answer;
+}
+
+answer_type Instance::download_nodeinfo()
 {
     auto answer{
         make_request(http_method::GET, _baseuri + "/.well-known/nodeinfo", {})};
@@ -112,14 +173,17 @@ answer_type Instance::get_nodeinfo()
     }
 
     vector<string> hrefs;
-    const regex re_href{R"("href"\s*:\s*"([^"]+)\")"};
-    smatch match;
-    string body = answer.body;
-    while (regex_search(body, match, re_href))
+    auto links{json_extract(answer.body, "links")};
+    string_view link;
+    while (json_next_element(links, link))
     {
-        hrefs.push_back(match[1].str());
+        hrefs.push_back(json_to_string(json_extract(link, "href")));
         debuglog << "Found href: " << hrefs.back() << '\n';
-        body = match.suffix();
+    }
+    if (hrefs.empty())
+    {
+        debuglog << "NodeInfo links not found.\n";
+        return answer;
     }
     sort(hrefs.begin(), hrefs.end()); // We assume they are sortable strings.
     debuglog << "Selecting href: " << hrefs.back() << '\n';
@@ -147,25 +211,20 @@ vector<string> Instance::get_post_formats() noexcept
             return _post_formats;
         }
 
-        const regex re_allformats(R"("postFormats"\s*:\s*\[([^\]]+)\])");
-        smatch match;
-        if (!regex_search(answer.body, match, re_allformats))
+        auto allformats{json_extract(answer.body, "metadata.postFormats")};
+        debuglog << "Found postFormats: " << allformats << '\n';
+        string_view format;
+        while (json_next_element(allformats, format))
+        {
+            _post_formats.push_back(json_to_string(format));
+            debuglog << "Found postFormat: " << _post_formats.back() << '\n';
+        }
+        if (_post_formats.empty())
         {
             debuglog << "Couldn't find metadata.postFormats.\n";
             _post_formats = {default_value};
             return _post_formats;
         }
-        string allformats{match[1].str()};
-        debuglog << "Found postFormats: " << allformats << '\n';
-
-        const regex re_format(R"(\s*"([^"]+)\"\s*,?)");
-
-        while (regex_search(allformats, match, re_format))
-        {
-            _post_formats.push_back(match[1].str());
-            allformats = match.suffix();
-            debuglog << "Found postFormat: " << _post_formats.back() << '\n';
-        }
     }
     catch (const std::exception &e)
     {
@@ -196,18 +255,9 @@ answer_type Instance::ObtainToken::step_1(const string_view client_name,
         make_request(http_method::POST, _baseuri + "/api/v1/apps", parameters)};
     if (answer)
     {
-        const regex re_id{R"("client_id"\s*:\s*"([^"]+)\")"};
-        const regex re_secret{R"("client_secret"\s*:\s*"([^"]+)\")"};
-        smatch match;
-
-        if (regex_search(answer.body, match, re_id))
-        {
-            _client_id = match[1].str();
-        }
-        if (regex_search(answer.body, match, re_secret))
-        {
-            _client_secret = match[1].str();
-        }
+        _client_id = json_to_string(json_extract(answer.body, "client_id"));
+        _client_secret = json_to_string(
+            json_extract(answer.body, "client_secret"));
 
         string uri{_baseuri + "/oauth/authorize?scope=" + escape_url(scopes)
                    + "&response_type=code"
@@ -241,12 +291,10 @@ answer_type Instance::ObtainToken::step_2(const string_view code)
         make_request(http_method::POST, _baseuri + "/oauth/token", parameters)};
     if (answer)
     {
-        const regex re_token{R"("access_token"\s*:\s*"([^"]+)\")"};
-        smatch match;
-
-        if (regex_search(answer.body, match, re_token))
+        auto token{json_to_string(json_extract(answer.body, "access_token"))};
+        if (!token.empty())
         {
-            answer.body = match[1].str();
+            answer.body = move(token);
             debuglog << "Got access token.\n";
             _instance.set_access_token(answer.body);
         }
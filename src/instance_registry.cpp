@@ -0,0 +1,246 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance_registry.hpp"
+
+#include "log.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <random>
+#include <system_error>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::error_code;
+using std::ifstream;
+using std::int64_t;
+using std::lock_guard;
+using std::make_shared;
+using std::move;
+using std::mt19937_64;
+using std::ofstream;
+using std::random_device;
+using std::chrono::duration_cast;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+//! The first line of the file.
+constexpr string_view file_magic{"mastodonpp-instances 1"};
+
+} // namespace
+
+shared_ptr<InstanceRegistry> InstanceRegistry::get()
+{
+    static const auto registry{make_shared<InstanceRegistry>()};
+    return registry;
+}
+
+InstanceRegistry::~InstanceRegistry() noexcept
+{
+    flush();
+}
+
+void InstanceRegistry::set_ttl(const seconds ttl)
+{
+    lock_guard<mutex> lock{_mutex};
+    _ttl = ttl;
+}
+
+void InstanceRegistry::set_persistence(string file)
+{
+    flush();
+
+    lock_guard<mutex> lock{_mutex};
+    _file = move(file);
+    if (!_file.empty())
+    {
+        read_file();
+    }
+}
+
+bool InstanceRegistry::lookup(const string_view hostname,
+                              const string_view field, string &value)
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto host{_records.find(hostname)};
+    if (host == _records.end())
+    {
+        return false;
+    }
+    const auto it{host->second.find(field)};
+    if (it == host->second.end()
+        || system_clock::now() - it->second.fetched >= _ttl)
+    {
+        return false;
+    }
+
+    debuglog << "Found " << field << " of " << hostname << " in registry.\n";
+    value = it->second.value;
+    return true;
+}
+
+void InstanceRegistry::store(const string_view hostname,
+                             const string_view field, string value)
+{
+    lock_guard<mutex> lock{_mutex};
+    if (_ttl <= seconds{0})
+    {
+        return;
+    }
+
+    auto &host{_records[string{hostname}]};
+    auto it{host.find(field)};
+    if (it == host.end())
+    {
+        it = host.emplace(string{field}, record{}).first;
+    }
+    it->second = {move(value), system_clock::now()};
+    _dirty = true;
+}
+
+void InstanceRegistry::erase(const string_view hostname)
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto host{_records.find(hostname)};
+    if (host == _records.end())
+    {
+        return;
+    }
+
+    _records.erase(host);
+    _dirty = true;
+}
+
+void InstanceRegistry::flush()
+{
+    // Copy the records, so that lookups don't wait for the disk.
+    lock_guard<mutex> write_lock{_write_mutex};
+    string file;
+    record_map records;
+    {
+        lock_guard<mutex> lock{_mutex};
+        if (!_dirty || _file.empty())
+        {
+            return;
+        }
+        file = _file;
+        records = _records;
+        _dirty = false;
+    }
+
+    write_file(file, records);
+}
+
+void InstanceRegistry::read_file()
+{
+    ifstream file{_file, std::ios::binary};
+    string line;
+    if (!getline(file, line))
+    {
+        return;
+    }
+    if (line != file_magic)
+    {
+        errorlog << "Unknown format of " << _file << '\n';
+        return;
+    }
+
+    // Every record is “hostname field fetched size\n”, then the value.
+    string hostname;
+    string field;
+    int64_t fetched{0};
+    size_t size{0};
+    file.seekg(0, std::ios::end);
+    const auto end{file.tellg()};
+    file.seekg(static_cast<std::streamoff>(line.size() + 1));
+    while (file >> hostname >> field >> fetched >> size)
+    {
+        file.ignore(1);
+        // Don't trust the size before allocating memory for it.
+        if (static_cast<std::streamoff>(size) > end - file.tellg())
+        {
+            errorlog << "File " << _file << " is truncated.\n";
+            return;
+        }
+        string value(size, '\0');
+        file.read(value.data(), static_cast<std::streamsize>(size));
+        if (!file)
+        {
+            errorlog << "File " << _file << " is truncated.\n";
+            return;
+        }
+
+        const system_clock::time_point time{seconds{fetched}};
+        auto &host{_records[hostname]};
+        const auto it{host.find(field)};
+        if (it == host.end() || it->second.fetched < time)
+        {
+            host[field] = {move(value), time};
+        }
+    }
+    debuglog << "Read instance metadata from " << _file << '\n';
+}
+
+void InstanceRegistry::write_file(const string &path,
+                                  const record_map &records)
+{
+    // Write into a new file and rename it, so that readers never see half a
+    // file.
+    thread_local mt19937_64 generator{random_device{}()};
+    auto temporary{path};
+    temporary += '.' + std::to_string(generator()) + ".tmp";
+    {
+        ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        file << file_magic << '\n';
+        for (const auto &host : records)
+        {
+            for (const auto &entry : host.second)
+            {
+                file << host.first << ' ' << entry.first << ' '
+                     << duration_cast<seconds>(
+                            entry.second.fetched.time_since_epoch())
+                            .count()
+                     << ' ' << entry.second.value.size() << '\n'
+                     << entry.second.value;
+            }
+        }
+        if (!file)
+        {
+            errorlog << "Could not write " << temporary << '\n';
+            error_code error;
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+
+    error_code error;
+    fs::rename(temporary, path, error);
+    if (error)
+    {
+        errorlog << "Could not write " << path << ": " << error.message()
+                 << '\n';
+        fs::remove(temporary, error);
+    }
+}
+
+} // namespace mastodonpp
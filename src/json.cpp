@@ -0,0 +1,639 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json.hpp"
+
+#include <charconv>
+#include <system_error>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::errc;
+using std::from_chars;
+using std::move;
+using std::uint32_t;
+
+namespace
+{
+
+bool read_hex(string_view &json, uint32_t &value)
+{
+    if (json.size() < 4)
+    {
+        return false;
+    }
+
+    value = 0;
+    for (const char c : json.substr(0, 4))
+    {
+        value <<= 4U;
+        if (c >= '0' && c <= '9')
+        {
+            value |= static_cast<uint32_t>(c - '0');
+        }
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') // NOLINT
+        {
+            value |= static_cast<uint32_t>((c | 0x20) - 'a' + 10); // NOLINT
+        }
+        else
+        {
+            return false;
+        }
+    }
+    json.remove_prefix(4);
+
+    return true;
+}
+
+void append_utf8(string &out, const uint32_t codepoint)
+{
+    // NOLINTBEGIN(hicpp-signed-bitwise, readability-magic-numbers)
+    if (codepoint < 0x80)
+    {
+        out += static_cast<char>(codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (codepoint >> 6U));
+        out += static_cast<char>(0x80 | (codepoint & 0x3FU));
+    }
+    else if (codepoint < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (codepoint >> 12U));
+        out += static_cast<char>(0x80 | ((codepoint >> 6U) & 0x3FU));
+        out += static_cast<char>(0x80 | (codepoint & 0x3FU));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (codepoint >> 18U));
+        out += static_cast<char>(0x80 | ((codepoint >> 12U) & 0x3FU));
+        out += static_cast<char>(0x80 | ((codepoint >> 6U) & 0x3FU));
+        out += static_cast<char>(0x80 | (codepoint & 0x3FU));
+    }
+    // NOLINTEND(hicpp-signed-bitwise, readability-magic-numbers)
+}
+
+void skip_whitespace(string_view &json) noexcept
+{
+    const auto pos{json.find_first_not_of(" \t\r\n")};
+    json.remove_prefix(pos == string_view::npos ? json.size() : pos);
+}
+
+bool skip_string(string_view &json) noexcept
+{
+    size_t pos{1};
+    while (pos < json.size())
+    {
+        pos = json.find_first_of("\"\\", pos);
+        if (pos == string_view::npos)
+        {
+            break;
+        }
+        if (json[pos] == '"')
+        {
+            json.remove_prefix(pos + 1);
+            return true;
+        }
+        pos += 2;
+    }
+
+    return false;
+}
+
+bool skip_value(string_view &json) noexcept
+{
+    if (json.empty())
+    {
+        return false;
+    }
+    if (json[0] == '"')
+    {
+        return skip_string(json);
+    }
+    if (json[0] != '{' && json[0] != '[')
+    {
+        const auto pos{json.find_first_of(" \t\r\n,:]}")};
+        json.remove_prefix(pos == string_view::npos ? json.size() : pos);
+        return true;
+    }
+
+    size_t depth{0};
+    while (!json.empty())
+    {
+        switch (json[0])
+        {
+        case '"':
+            if (!skip_string(json))
+            {
+                return false;
+            }
+            continue;
+        case '{':
+        case '[':
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            --depth;
+            break;
+        default:
+            break;
+        }
+        json.remove_prefix(1);
+        if (depth == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//! Returns the value of @a key in the object at the start of @a json.
+string_view find_member(string_view json, const string_view key) noexcept
+{
+    skip_whitespace(json);
+    if (json.empty() || json[0] != '{')
+    {
+        return {};
+    }
+    json.remove_prefix(1);
+
+    while (true)
+    {
+        skip_whitespace(json);
+        const auto member{json};
+        if (json.empty() || json[0] != '"' || !skip_string(json))
+        {
+            return {};
+        }
+        const bool found{member.substr(1, member.size() - json.size() - 2)
+                         == key};
+        skip_whitespace(json);
+        if (json.empty() || json[0] != ':')
+        {
+            return {};
+        }
+        json.remove_prefix(1);
+        skip_whitespace(json);
+
+        const auto value{json};
+        if (!skip_value(json))
+        {
+            return {};
+        }
+        if (found)
+        {
+            return value.substr(0, value.size() - json.size());
+        }
+
+        skip_whitespace(json);
+        if (json.empty() || json[0] != ',')
+        {
+            return {};
+        }
+        json.remove_prefix(1);
+    }
+}
+
+} // namespace
+
+void JSONIndexer::feed(const string_view data)
+{
+    size_t pos{0};
+    while (!_failed && pos < data.size())
+    {
+        switch (_state)
+        {
+        case state::text:
+        {
+            pos = data.find_first_of("\"\\", pos);
+            if (pos == string_view::npos)
+            {
+                pos = data.size();
+            }
+            else if (data[pos] == '\\')
+            {
+                _state = state::escape;
+                ++pos;
+            }
+            else
+            {
+                close_last(_offset + pos + 1);
+                ++pos;
+            }
+            break;
+        }
+        case state::escape:
+        {
+            _state = state::text;
+            ++pos;
+            break;
+        }
+        case state::scalar:
+        {
+            pos = data.find_first_of(" \t\r\n,:]}", pos);
+            if (pos == string_view::npos)
+            {
+                pos = data.size();
+            }
+            else
+            {
+                close_last(_offset + pos);
+            }
+            break;
+        }
+        case state::value:
+        {
+            const char c{data[pos]};
+            switch (c)
+            {
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+            case ',':
+            case ':':
+                break;
+            case '{':
+            case '[':
+            {
+                _open.push_back(_nodes.size());
+                _nodes.push_back({c == '{' ? json_type::object
+                                           : json_type::array,
+                                  _offset + pos, 0, 0});
+                break;
+            }
+            case '}':
+            case ']':
+            {
+                const json_type type{c == '}' ? json_type::object
+                                              : json_type::array};
+                if (_open.empty() || _nodes[_open.back()].type != type)
+                {
+                    _failed = true;
+                    break;
+                }
+                auto &node{_nodes[_open.back()]};
+                node.end = _offset + pos + 1;
+                node.next = _nodes.size();
+                _open.pop_back();
+                break;
+            }
+            case '"':
+            {
+                _nodes.push_back({json_type::text, _offset + pos, 0,
+                                  _nodes.size() + 1});
+                _state = state::text;
+                break;
+            }
+            default:
+            {
+                json_type type{json_type::number};
+                if (c == 't' || c == 'f')
+                {
+                    type = json_type::boolean;
+                }
+                else if (c == 'n')
+                {
+                    type = json_type::null;
+                }
+                _nodes.push_back({type, _offset + pos, 0, _nodes.size() + 1});
+                _state = state::scalar;
+                break;
+            }
+            }
+            ++pos;
+            break;
+        }
+        }
+    }
+
+    _offset += data.size();
+}
+
+bool JSONIndexer::complete() const noexcept
+{
+    return !_failed && !_nodes.empty() && _open.empty()
+           && (_state == state::value || _state == state::scalar);
+}
+
+vector<json_node> JSONIndexer::take_nodes()
+{
+    // A number at the end of the document has no delimiter after it.
+    if (_state == state::scalar)
+    {
+        close_last(_offset);
+    }
+
+    vector<json_node> nodes;
+    if (complete())
+    {
+        nodes = move(_nodes);
+    }
+    reset();
+
+    return nodes;
+}
+
+void JSONIndexer::reset()
+{
+    _nodes.clear();
+    _open.clear();
+    _offset = 0;
+    _state = state::value;
+    _failed = false;
+}
+
+void JSONIndexer::close_last(const size_t end)
+{
+    _nodes.back().end = end;
+    _state = state::value;
+}
+
+JSONValue::JSONValue(const string_view document,
+                     const vector<json_node> &nodes, const size_t index)
+    : _document{document}
+    , _nodes{nodes.data()}
+    , _size{nodes.size()}
+    , _index{index}
+{}
+
+string_view JSONValue::raw() const noexcept
+{
+    if (!valid())
+    {
+        return {};
+    }
+
+    const auto &node{_nodes[_index]};
+    return _document.substr(node.begin, node.end - node.begin);
+}
+
+JSONValue JSONValue::operator[](const string_view key) const noexcept
+{
+    if (type() != json_type::object)
+    {
+        return {};
+    }
+
+    const size_t end{_nodes[_index].next};
+    size_t index{_index + 1};
+    while (index < end)
+    {
+        const size_t value{_nodes[index].next};
+        if (value >= end)
+        {
+            break;
+        }
+        if (at_index(index).get_string_view() == key)
+        {
+            return at_index(value);
+        }
+        index = _nodes[value].next;
+    }
+
+    return {};
+}
+
+JSONValue JSONValue::operator[](size_t position) const noexcept
+{
+    for (auto element : *this)
+    {
+        if (position == 0)
+        {
+            return element;
+        }
+        --position;
+    }
+
+    return {};
+}
+
+size_t JSONValue::size() const noexcept
+{
+    const auto own_type{type()};
+    if (own_type != json_type::object && own_type != json_type::array)
+    {
+        return 0;
+    }
+
+    size_t size{0};
+    const size_t end{_nodes[_index].next};
+    for (size_t index{_index + 1}; index < end; index = _nodes[index].next)
+    {
+        ++size;
+    }
+
+    return own_type == json_type::object ? size / 2 : size;
+}
+
+JSONValue::iterator JSONValue::begin() const noexcept
+{
+    if (type() != json_type::array)
+    {
+        return end();
+    }
+
+    return iterator{at_index(_index + 1)};
+}
+
+JSONValue::iterator JSONValue::end() const noexcept
+{
+    if (type() != json_type::array)
+    {
+        return iterator{*this};
+    }
+
+    return iterator{at_index(_nodes[_index].next)};
+}
+
+string JSONValue::get_string() const
+{
+    string out;
+    const auto escaped{get_string_view()};
+    out.reserve(escaped.size());
+    unescape_json(escaped, out);
+
+    return out;
+}
+
+string_view JSONValue::get_string_view() const noexcept
+{
+    if (type() != json_type::text)
+    {
+        return {};
+    }
+
+    const auto text{raw()};
+    return text.substr(1, text.size() - 2);
+}
+
+int64_t JSONValue::get_int(const int64_t fallback) const noexcept
+{
+    if (type() != json_type::number)
+    {
+        return fallback;
+    }
+
+    const auto text{raw()};
+    int64_t value{0};
+    const auto result{
+        from_chars(text.data(), text.data() + text.size(), value)};
+    if (result.ec != errc{} || result.ptr != text.data() + text.size())
+    {
+        return fallback;
+    }
+
+    return value;
+}
+
+bool JSONValue::get_bool(const bool fallback) const noexcept
+{
+    if (type() != json_type::boolean)
+    {
+        return fallback;
+    }
+
+    return raw() == "true";
+}
+
+JSONValue JSONValue::at_index(const size_t index) const noexcept
+{
+    JSONValue value{*this};
+    value._index = index;
+
+    return value;
+}
+
+string_view json_extract(string_view json, string_view path) noexcept
+{
+    while (!json.empty())
+    {
+        const auto pos{path.find('.')};
+        json = find_member(json, path.substr(0, pos));
+        if (pos == string_view::npos)
+        {
+            return json;
+        }
+        path.remove_prefix(pos + 1);
+    }
+
+    return {};
+}
+
+bool json_next_element(string_view &array, string_view &element) noexcept
+{
+    // Before the first element is the '[', before the others a ','.
+    skip_whitespace(array);
+    if (array.empty() || (array[0] != '[' && array[0] != ','))
+    {
+        return false;
+    }
+    array.remove_prefix(1);
+    skip_whitespace(array);
+    if (array.empty() || array[0] == ']')
+    {
+        return false;
+    }
+
+    const auto start{array};
+    if (!skip_value(array))
+    {
+        return false;
+    }
+    element = start.substr(0, start.size() - array.size());
+
+    return true;
+}
+
+string json_to_string(const string_view json)
+{
+    string out;
+    if (json.size() < 2 || json.front() != '"' || json.back() != '"')
+    {
+        return out;
+    }
+
+    out.reserve(json.size() - 2);
+    unescape_json(json.substr(1, json.size() - 2), out);
+
+    return out;
+}
+
+void unescape_json(string_view escaped, string &out)
+{
+    while (!escaped.empty())
+    {
+        const auto pos{escaped.find('\\')};
+        out.append(escaped.substr(0, pos));
+        if (pos == string_view::npos || pos + 1 >= escaped.size())
+        {
+            return;
+        }
+
+        const char c{escaped[pos + 1]};
+        escaped.remove_prefix(pos + 2);
+        switch (c)
+        {
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u':
+        {
+            uint32_t codepoint{0};
+            if (!read_hex(escaped, codepoint))
+            {
+                return;
+            }
+            // Characters outside of the BMP are encoded as surrogate pairs.
+            uint32_t low{0};
+            if (codepoint >= 0xD800 && codepoint < 0xDC00 // NOLINT
+                && escaped.substr(0, 2) == "\\u")
+            {
+                escaped.remove_prefix(2);
+                if (!read_hex(escaped, low))
+                {
+                    return;
+                }
+                // NOLINTNEXTLINE(readability-magic-numbers)
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10U)
+                            + (low - 0xDC00); // NOLINT
+            }
+            append_utf8(out, codepoint);
+            break;
+        }
+        default:
+            out += c;
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,197 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "media_uploader.hpp"
+
+#include "api.hpp"
+#include "exceptions.hpp"
+#include "json.hpp"
+#include "log.hpp"
+
+#include <exception>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::exception;
+using std::lock_guard;
+using std::make_shared;
+using std::move;
+using std::promise;
+using std::chrono::steady_clock;
+
+//! An upload that is not finished.
+struct MediaUploader::Upload
+{
+    upload_callback callback;
+    //! The ID of the attachment, once the server sent it.
+    string id;
+    milliseconds poll_interval;
+    steady_clock::time_point poll_deadline;
+};
+
+namespace
+{
+
+constexpr uint16_t http_ok{200};
+constexpr uint16_t http_accepted{202};
+constexpr uint16_t http_partial_content{206};
+
+} // namespace
+
+MediaUploader::MediaUploader(const Instance &instance)
+    : _dispatcher{instance}
+{}
+
+future<media_upload> MediaUploader::upload(const attachment &file,
+                                           const parametermap &parameters,
+                                           progress_callback progress)
+{
+    auto result_promise{make_shared<promise<media_upload>>()};
+    auto result_future{result_promise->get_future()};
+
+    upload(
+        file, parameters,
+        [result_promise](media_upload result)
+        { result_promise->set_value(move(result)); },
+        move(progress));
+
+    return result_future;
+}
+
+void MediaUploader::upload(const attachment &file,
+                           const parametermap &parameters,
+                           upload_callback callback,
+                           progress_callback progress)
+{
+    auto upload{make_shared<Upload>()};
+    upload->callback = move(callback);
+    {
+        lock_guard<mutex> lock{_mutex};
+        upload->poll_interval = _poll_interval;
+        upload->poll_deadline = steady_clock::now() + _poll_timeout;
+    }
+
+    parametermap form{parameters};
+    form.insert_or_assign("file", file);
+
+    ++_active_uploads;
+    try
+    {
+        _dispatcher.submit(
+            http_method::POST, API::v2::media, form,
+            [this, upload](answer_type answer)
+            { process(upload, move(answer)); },
+            move(progress));
+    }
+    catch (const CURLException &)
+    {
+        --_active_uploads;
+        throw;
+    }
+}
+
+void MediaUploader::set_polling(const milliseconds interval,
+                                const milliseconds timeout)
+{
+    lock_guard<mutex> lock{_mutex};
+    _poll_interval = interval;
+    _poll_timeout = timeout;
+}
+
+void MediaUploader::set_max_connections(const long max) // NOLINT
+{
+    _dispatcher.set_max_connections(max);
+}
+
+size_t MediaUploader::get_active_uploads() const noexcept
+{
+    return _active_uploads;
+}
+
+void MediaUploader::process(const shared_ptr<Upload> &upload,
+                            answer_type answer)
+{
+    const bool polling{!upload->id.empty()};
+    if (!polling && (answer.http_status == http_ok
+                     || answer.http_status == http_accepted))
+    {
+        upload->id = json_to_string(json_extract(answer.body, "id"));
+        if (upload->id.empty())
+        {
+            errorlog << "The server did not send the ID of the attachment.\n";
+            finish(upload, move(answer), false);
+            return;
+        }
+    }
+
+    // While the attachment is processed, the server answers polls with 206.
+    if (answer.http_status == http_accepted
+        || (polling && answer.http_status == http_partial_content))
+    {
+        if (steady_clock::now() + upload->poll_interval > upload->poll_deadline)
+        {
+            answer.curl_error_code = CURLE_OPERATION_TIMEDOUT;
+            answer.error_message = "Timed out waiting for the processing.";
+            finish(upload, move(answer), false);
+            return;
+        }
+
+        debuglog << "Media attachment " << upload->id
+                 << " is being processed.\n";
+        try
+        {
+            _dispatcher.submit_after(upload->poll_interval, http_method::GET,
+                                     API::v1::media_id, {{"id", upload->id}},
+                                     [this, upload](answer_type next)
+                                     { process(upload, move(next)); });
+        }
+        catch (const CURLException &e)
+        {
+            answer.curl_error_code = static_cast<uint8_t>(e.error_code);
+            answer.error_message = e.what();
+            finish(upload, move(answer), false);
+        }
+        return;
+    }
+
+    const bool success{answer.http_status == http_ok};
+    finish(upload, move(answer), success);
+}
+
+void MediaUploader::finish(const shared_ptr<Upload> &upload,
+                           answer_type answer, const bool success)
+{
+    media_upload result;
+    if (success)
+    {
+        result.id = move(upload->id);
+    }
+    result.answer = move(answer);
+
+    --_active_uploads;
+    try
+    {
+        upload->callback(move(result));
+    }
+    catch (const exception &e)
+    {
+        errorlog << "Exception in callback: " << e.what() << '\n';
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,220 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "paginator.hpp"
+
+#include "log.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::get;
+using std::holds_alternative;
+using std::lock_guard;
+using std::make_unique;
+using std::max;
+using std::move;
+using std::rethrow_exception;
+using std::unique_lock;
+
+Paginator::Paginator(const Instance &instance, const endpoint_variant &endpoint,
+                     const parametermap &parameters, const size_t depth,
+                     stop_condition stop)
+    : _connection{make_unique<Connection>(instance)}
+    , _endpoint{endpoint}
+    , _depth{max<size_t>(depth, 1)}
+    , _stop{move(stop)}
+{
+    if (holds_alternative<string_view>(endpoint))
+    {
+        _endpoint_storage = get<string_view>(endpoint);
+        _endpoint = string_view(_endpoint_storage);
+    }
+
+    _fetch = [this](const parametermap &params)
+    { return _connection->get(_endpoint, params); };
+    // Aborts the running request when the Paginator is destroyed. Unlike
+    // cancel_stream(), this is not reset by the next request.
+    _connection->set_progress_callback([this](const transfer_progress &)
+                                       { return !_stopped; });
+
+    start(parameters);
+}
+
+Paginator::Paginator(page_fetcher fetch, const parametermap &parameters,
+                     const size_t depth, stop_condition stop)
+    : _depth{max<size_t>(depth, 1)}
+    , _stop{move(stop)}
+    , _fetch{move(fetch)}
+{
+    start(parameters);
+}
+
+Paginator::~Paginator() noexcept
+{
+    {
+        lock_guard<mutex> lock{_mutex};
+        _stopped = true;
+    }
+    _space_free.notify_one();
+    _thread.join();
+}
+
+void Paginator::start(const parametermap &parameters)
+{
+    for (const auto &param : parameters)
+    {
+        // Attachments are not sent with GET.
+        if (holds_alternative<attachment>(param.second))
+        {
+            continue;
+        }
+
+        const string_view key{_parameter_storage.emplace_back(param.first)};
+        if (holds_alternative<string_view>(param.second))
+        {
+            const auto &value{get<string_view>(param.second)};
+            _parameters.emplace(key, _parameter_storage.emplace_back(value));
+        }
+        else
+        {
+            vector<string_view> values;
+            for (const auto &value : get<vector<string_view>>(param.second))
+            {
+                values.emplace_back(_parameter_storage.emplace_back(value));
+            }
+            _parameters.emplace(key, move(values));
+        }
+    }
+
+    _thread = thread{[this] { run(); }};
+}
+
+Paginator::iterator::iterator(Paginator *paginator)
+    : _paginator{paginator}
+{
+    ++*this;
+}
+
+Paginator::iterator &Paginator::iterator::operator++()
+{
+    if (_paginator != nullptr && !_paginator->next_page(_page))
+    {
+        _paginator = nullptr;
+    }
+
+    return *this;
+}
+
+bool Paginator::next_page(answer_type &page)
+{
+    unique_lock<mutex> lock{_mutex};
+    _page_ready.wait(lock, [this] { return !_pages.empty() || _finished; });
+    if (_pages.empty())
+    {
+        if (_exception)
+        {
+            rethrow_exception(_exception);
+        }
+        return false;
+    }
+
+    page = move(_pages.front());
+    _pages.pop_front();
+    lock.unlock();
+    _space_free.notify_one();
+
+    return true;
+}
+
+void Paginator::run() noexcept
+{
+    try
+    {
+        fetch_pages();
+    }
+    catch (...)
+    {
+        lock_guard<mutex> lock{_mutex};
+        _exception = std::current_exception();
+    }
+
+    {
+        lock_guard<mutex> lock{_mutex};
+        _finished = true;
+    }
+    _page_ready.notify_one();
+}
+
+void Paginator::fetch_pages()
+{
+    parametermap parameters{_parameters};
+    // The parameters of the next page point into the previous page, which is
+    // handed over to the consumer. So they are copied.
+    deque<string> storage;
+
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock{_mutex};
+            _space_free.wait(
+                lock, [this] { return _stopped || _pages.size() < _depth; });
+            if (_stopped)
+            {
+                return;
+            }
+        }
+
+        auto page{_fetch(parameters)};
+        if (_stopped)
+        {
+            return;
+        }
+        const auto next{page.next()};
+        const bool last{!page || next.empty() || page.body == "[]"
+                        || (_stop && _stop(page))};
+        if (!last)
+        {
+            deque<string> next_storage;
+            parameters = _parameters;
+            for (const auto &param : next)
+            {
+                parameters.insert_or_assign(
+                    next_storage.emplace_back(param.first),
+                    string_view(next_storage.emplace_back(
+                        get<string_view>(param.second))));
+            }
+            storage.swap(next_storage);
+        }
+
+        {
+            lock_guard<mutex> lock{_mutex};
+            _pages.push_back(move(page));
+        }
+        _page_ready.notify_one();
+
+        if (last)
+        {
+            debuglog << "Paginator reached the last page.\n";
+            return;
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,332 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rate_limiter.hpp"
+
+#include "hash.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::errc;
+using std::from_chars;
+using std::lock_guard;
+using std::make_shared;
+using std::map;
+using std::max;
+using std::min;
+using std::pair;
+using std::string;
+using std::weak_ptr;
+using std::chrono::ceil;
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+namespace
+{
+
+//! Start pacing when less than 1/10 of the limit is left.
+constexpr int64_t low_water_divisor{10};
+
+string_view trim(string_view text) noexcept
+{
+    const auto start{text.find_first_not_of(" \t\r\n")};
+    if (start == string_view::npos)
+    {
+        return {};
+    }
+    text.remove_prefix(start);
+    return text.substr(0, text.find_last_not_of(" \t\r\n") + 1);
+}
+
+//! Returns the number in @a text or -1.
+int64_t parse_int(string_view text) noexcept
+{
+    text = trim(text);
+    int64_t value{-1};
+    const auto result{
+        from_chars(text.data(), text.data() + text.size(), value)};
+    if (result.ec != errc{} || result.ptr != text.data() + text.size())
+    {
+        return -1;
+    }
+    return value;
+}
+
+//! Days since 1970-01-01. See http://howardhinnant.github.io/date_algorithms.
+int64_t days_from_civil(int64_t year, const int64_t month, const int64_t day)
+{
+    // NOLINTBEGIN(readability-magic-numbers)
+    year -= month <= 2 ? 1 : 0;
+    const int64_t era{(year >= 0 ? year : year - 399) / 400};
+    const int64_t year_of_era{year - era * 400};
+    const int64_t day_of_year{(153 * (month > 2 ? month - 3 : month + 9) + 2)
+                                  / 5
+                              + day - 1};
+    const int64_t day_of_era{year_of_era * 365 + year_of_era / 4
+                             - year_of_era / 100 + day_of_year};
+    return era * 146097 + day_of_era - 719468;
+    // NOLINTEND(readability-magic-numbers)
+}
+
+/*!
+ *  Parse an ISO 8601 datetime like `2020-01-01T12:00:00.000Z`.
+ *
+ *  @return false if it could not be parsed.
+ */
+bool parse_iso8601(string_view text, system_clock::time_point &time) noexcept
+{
+    text = trim(text);
+    // The positions of the numbers in "YYYY-MM-DDTHH:MM:SS".
+    constexpr size_t min_size{19};
+    if (text.size() < min_size)
+    {
+        return false;
+    }
+
+    const auto number{[text](const size_t pos, const size_t size)
+                      {
+                          int64_t value{-1};
+                          const auto *begin{text.data() + pos};
+                          const auto result{
+                              from_chars(begin, begin + size, value)};
+                          return result.ptr == begin + size ? value : -1;
+                      }};
+    // NOLINTBEGIN(readability-magic-numbers)
+    const int64_t year{number(0, 4)};
+    const int64_t month{number(5, 2)};
+    const int64_t day{number(8, 2)};
+    const int64_t hour{number(11, 2)};
+    const int64_t minute{number(14, 2)};
+    const int64_t second{number(17, 2)};
+    if (year < 0 || month < 1 || day < 1 || hour < 0 || minute < 0
+        || second < 0)
+    {
+        return false;
+    }
+
+    // Up to microseconds of the fraction are used.
+    constexpr size_t max_fraction_digits{6};
+    int64_t microseconds{0};
+    size_t pos{min_size};
+    if (text.size() > pos && text[pos] == '.')
+    {
+        int64_t factor{100000};
+        for (++pos; pos < text.size() && text[pos] >= '0' && text[pos] <= '9';
+             ++pos)
+        {
+            if (pos - min_size <= max_fraction_digits)
+            {
+                microseconds += (text[pos] - '0') * factor;
+                factor /= 10;
+            }
+        }
+    }
+
+    // Apply the offset, if any.
+    int64_t offset{0};
+    pos = text.find_first_of("+-", pos);
+    if (pos != string_view::npos && text.size() >= pos + 6)
+    {
+        offset = (number(pos + 1, 2) * 60 + number(pos + 4, 2)) * 60;
+        if (text[pos] == '-')
+        {
+            offset = -offset;
+        }
+    }
+
+    const int64_t epoch{days_from_civil(year, month, day) * 86400
+                        + hour * 3600 + minute * 60 + second - offset};
+    // NOLINTEND(readability-magic-numbers)
+    time = system_clock::time_point{
+        duration_cast<system_clock::duration>(
+            seconds{epoch} + std::chrono::microseconds{microseconds})};
+
+    return true;
+}
+
+} // namespace
+
+shared_ptr<RateLimiter> RateLimiter::get(const string_view hostname,
+                                         const string_view access_token)
+{
+    static mutex registry_mutex;
+    // Keyed by a hash of the access token, so that it doesn't linger in
+    // memory.
+    static map<pair<string, string>, weak_ptr<RateLimiter>> registry;
+
+    lock_guard<mutex> lock{registry_mutex};
+    for (auto it{registry.begin()}; it != registry.end();)
+    {
+        it = it->second.expired() ? registry.erase(it) : std::next(it);
+    }
+
+    auto &entry{registry[{string{hostname}, hash_hex(access_token)}]};
+    auto limiter{entry.lock()};
+    if (!limiter)
+    {
+        debuglog << "New rate limiter for " << hostname << '\n';
+        limiter = make_shared<RateLimiter>();
+        entry = limiter;
+    }
+
+    return limiter;
+}
+
+steady_clock::time_point RateLimiter::reserve()
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto now{steady_clock::now()};
+    drop_past_slots(now);
+    ++_metrics.requests;
+    ++_in_flight;
+
+    // After the reset, we know nothing until the next answer.
+    if (_known && now >= _reset)
+    {
+        _known = false;
+    }
+
+    time_point slot{now};
+    if (_known)
+    {
+        slot = max(now, _next_slot);
+        if (_tokens > 0)
+        {
+            --_tokens;
+            // Spread the last tokens evenly until the reset.
+            if (_tokens < max(_limit / low_water_divisor, int64_t{1}))
+            {
+                _next_slot = slot + (_reset - slot) / (_tokens + 1);
+            }
+        }
+        else
+        {
+            // Wait for the reset, and for more windows if it is not enough.
+            const int64_t windows{_overdrawn / max(_limit, int64_t{1})};
+            slot = _reset + _window * windows;
+            ++_overdrawn;
+        }
+    }
+
+    if (slot > now)
+    {
+        const auto wait{ceil<milliseconds>(slot - now)};
+        ++_metrics.delayed;
+        _metrics.total_wait += wait;
+        _metrics.max_wait = max(_metrics.max_wait, wait);
+        _scheduled.push(slot);
+        debuglog << "Rate limit: request has to wait " << wait.count()
+                 << " ms.\n";
+    }
+
+    return slot;
+}
+
+void RateLimiter::release(const answer_type &answer)
+{
+    const int64_t limit{parse_int(answer.get_header("X-RateLimit-Limit"))};
+    int64_t remaining{parse_int(answer.get_header("X-RateLimit-Remaining"))};
+    system_clock::time_point reset;
+    bool has_reset{
+        parse_iso8601(answer.get_header("X-RateLimit-Reset"), reset)};
+
+    constexpr uint16_t too_many_requests{429};
+    if (answer.http_status == too_many_requests)
+    {
+        remaining = 0;
+        const int64_t retry_after{
+            parse_int(answer.get_header("Retry-After"))};
+        if (retry_after >= 0)
+        {
+            reset = system_clock::now() + seconds{retry_after};
+            has_reset = true;
+        }
+    }
+
+    lock_guard<mutex> lock{_mutex};
+    if (_in_flight > 0)
+    {
+        --_in_flight;
+    }
+    if (answer.http_status == too_many_requests)
+    {
+        ++_metrics.rejected;
+    }
+    if (remaining < 0 || !has_reset)
+    {
+        return;
+    }
+
+    // The clocks of the server and ours may differ a bit, but the windows are
+    // long.
+    const time_point new_reset{
+        steady_clock::now()
+        + duration_cast<steady_clock::duration>(reset - system_clock::now())};
+    int64_t tokens{remaining - static_cast<int64_t>(_in_flight)};
+    // Answers can arrive out of order. Within a window, the lowest count wins.
+    if (_known && new_reset - _reset < seconds{1}
+        && _reset - new_reset < seconds{1})
+    {
+        tokens = min(tokens, _tokens);
+    }
+    else
+    {
+        // The distance between two resets is the length of the window.
+        if (_reset != time_point{} && new_reset > _reset + seconds{1})
+        {
+            _window = new_reset - _reset;
+        }
+        _overdrawn = 0;
+    }
+
+    _known = true;
+    _limit = max(limit, remaining);
+    _tokens = max(tokens, int64_t{0});
+    _reset = new_reset;
+    _metrics.limit = limit;
+    _metrics.remaining = remaining;
+}
+
+rate_limit_metrics RateLimiter::get_metrics()
+{
+    lock_guard<mutex> lock{_mutex};
+    drop_past_slots(steady_clock::now());
+    auto metrics{_metrics};
+    metrics.queued = _scheduled.size();
+
+    return metrics;
+}
+
+void RateLimiter::drop_past_slots(const time_point now)
+{
+    while (!_scheduled.empty() && _scheduled.top() <= now)
+    {
+        _scheduled.pop();
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,419 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "response_cache.hpp"
+
+#include "curl/curl.h"
+#include "hash.hpp"
+#include "json.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <random>
+#include <system_error>
+
+namespace mastodonpp
+{
+
+using std::error_code;
+using std::from_chars;
+using std::ifstream;
+using std::int64_t;
+using std::lock_guard;
+using std::move;
+using std::mt19937_64;
+using std::nullopt;
+using std::ofstream;
+using std::optional;
+using std::random_device;
+using std::uint16_t;
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr uint16_t http_ok{200};
+constexpr uint16_t http_not_modified{304};
+
+//! The first line of the files of the DiskCache.
+constexpr string_view file_magic{"mastodonpp-cache 1"};
+
+string_view trim(string_view text) noexcept
+{
+    const auto start{text.find_first_not_of(" \t\r\n")};
+    if (start == string_view::npos)
+    {
+        return {};
+    }
+    text.remove_prefix(start);
+    return text.substr(0, text.find_last_not_of(" \t\r\n") + 1);
+}
+
+//! Returns the value of a header, without surrounding whitespace.
+string_view header(const answer_type &answer, const string_view field)
+{
+    return trim(answer.get_header(field));
+}
+
+bool has_validators(const answer_type &answer)
+{
+    return !header(answer, "ETag").empty()
+           || !header(answer, "Last-Modified").empty();
+}
+
+/*!
+ *  @brief  Returns until when an answer is fresh.
+ *
+ *  @return The time, which may be now, or nullopt if the answer must not be
+ *          stored.
+ */
+optional<system_clock::time_point> freshness(const answer_type &answer)
+{
+    const auto now{system_clock::now()};
+    bool no_cache{false};
+    int64_t max_age{-1};
+
+    string_view control{header(answer, "Cache-Control")};
+    while (!control.empty())
+    {
+        const auto comma{control.find(',')};
+        const string_view directive{trim(control.substr(0, comma))};
+        control.remove_prefix(comma == string_view::npos ? control.size()
+                                                         : comma + 1);
+
+        const auto equals{directive.find('=')};
+        string name{directive.substr(0, equals)};
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](const unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        if (name == "no-store")
+        {
+            return nullopt;
+        }
+        if (name == "no-cache")
+        {
+            no_cache = true;
+        }
+        else if (name == "max-age" && equals != string_view::npos)
+        {
+            string_view value{directive.substr(equals + 1)};
+            if (!value.empty() && value.front() == '"')
+            {
+                value = value.substr(1, value.size() - 2);
+            }
+            from_chars(value.data(), value.data() + value.size(), max_age);
+        }
+    }
+
+    if (no_cache)
+    {
+        return now;
+    }
+    if (max_age >= 0)
+    {
+        int64_t age{0};
+        const string_view age_value{header(answer, "Age")};
+        from_chars(age_value.data(), age_value.data() + age_value.size(),
+                   age);
+        return now + seconds{std::max(max_age - age, int64_t{0})};
+    }
+
+    const string_view expires{header(answer, "Expires")};
+    if (!expires.empty())
+    {
+        const time_t date{curl_getdate(string{expires}.c_str(), nullptr)};
+        if (date >= 0)
+        {
+            return std::max(system_clock::from_time_t(date), now);
+        }
+    }
+
+    return now;
+}
+
+} // namespace
+
+vector<string> cache_entry::conditional_headers() const
+{
+    vector<string> headers;
+    const string_view etag{header(answer, "ETag")};
+    if (!etag.empty())
+    {
+        headers.push_back(string{"If-None-Match: "} += etag);
+    }
+    const string_view last_modified{header(answer, "Last-Modified")};
+    if (!last_modified.empty())
+    {
+        headers.push_back(string{"If-Modified-Since: "} += last_modified);
+    }
+
+    return headers;
+}
+
+string ResponseCache::make_key(const string_view uri,
+                               const string_view access_token)
+{
+    string key{"GET "};
+    key += uri;
+    key += ' ';
+    key += access_token.empty() ? "-" : hash_hex(access_token);
+
+    return key;
+}
+
+bool ResponseCache::lookup(const string &key, cache_entry &entry)
+{
+    if (!load(key, entry))
+    {
+        return false;
+    }
+
+    if (entry.fresh())
+    {
+        ++_hits;
+        debuglog << "Cache hit: " << key << '\n';
+    }
+    return true;
+}
+
+answer_type ResponseCache::update(const string &key, answer_type answer,
+                                  cache_entry *stale)
+{
+    if (answer.http_status == http_not_modified && stale != nullptr)
+    {
+        ++_revalidated;
+        debuglog << "Cache revalidated: " << key << '\n';
+
+        // The 304 carries the new freshness information.
+        const auto expires{freshness(answer)};
+        if (expires)
+        {
+            stale->expires = *expires;
+            save(key, *stale);
+        }
+        else
+        {
+            remove(key);
+        }
+        return move(stale->answer);
+    }
+
+    ++_misses;
+    if (answer.http_status == http_ok && answer.curl_error_code == 0)
+    {
+        const auto expires{freshness(answer)};
+        if (!expires)
+        {
+            remove(key);
+        }
+        else if (*expires > system_clock::now() || has_validators(answer))
+        {
+            save(key, {answer, *expires});
+            ++_stored;
+        }
+    }
+
+    return answer;
+}
+
+cache_metrics ResponseCache::get_metrics() const noexcept
+{
+    cache_metrics metrics;
+    metrics.hits = _hits;
+    metrics.revalidated = _revalidated;
+    metrics.misses = _misses;
+    metrics.stored = _stored;
+    metrics.evicted = _evicted;
+
+    return metrics;
+}
+
+MemoryCache::MemoryCache(const size_t capacity)
+    : _capacity{capacity}
+{
+    _index.reserve(capacity);
+}
+
+bool MemoryCache::load(const string &key, cache_entry &entry)
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto it{_index.find(key)};
+    if (it == _index.end())
+    {
+        return false;
+    }
+
+    _entries.splice(_entries.begin(), _entries, it->second);
+    entry = it->second->second;
+
+    return true;
+}
+
+void MemoryCache::save(const string &key, const cache_entry &entry)
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto it{_index.find(key)};
+    if (it != _index.end())
+    {
+        it->second->second = entry;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return;
+    }
+    if (_capacity == 0)
+    {
+        return;
+    }
+
+    _entries.emplace_front(key, entry);
+    _index.emplace(key, _entries.begin());
+    while (_entries.size() > _capacity)
+    {
+        _index.erase(_entries.back().first);
+        _entries.pop_back();
+        count_eviction();
+    }
+}
+
+void MemoryCache::remove(const string &key)
+{
+    lock_guard<mutex> lock{_mutex};
+    const auto it{_index.find(key)};
+    if (it != _index.end())
+    {
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+}
+
+DiskCache::DiskCache(string directory)
+    : _directory{move(directory)}
+{
+    error_code error;
+    fs::create_directories(_directory, error);
+    if (error)
+    {
+        errorlog << "Could not create cache directory " << _directory << ": "
+                 << error.message() << '\n';
+    }
+}
+
+bool DiskCache::load(const string &key, cache_entry &entry)
+{
+    ifstream file{file_path(key), std::ios::binary};
+    string line;
+    if (!getline(file, line) || line != file_magic)
+    {
+        return false;
+    }
+    // Different keys can have the same hash.
+    if (!getline(file, line) || line != key)
+    {
+        return false;
+    }
+
+    int64_t expires{0};
+    unsigned int http_status{0};
+    size_t headers_size{0};
+    size_t body_size{0};
+    bool indexed{false};
+    file >> expires >> http_status >> headers_size >> body_size >> indexed;
+    file.ignore(1);
+
+    answer_type answer;
+    answer.http_status = static_cast<uint16_t>(http_status);
+    answer.headers.resize(headers_size);
+    answer.body.resize(body_size);
+    file.read(answer.headers.data(),
+              static_cast<std::streamsize>(headers_size));
+    file.read(answer.body.data(), static_cast<std::streamsize>(body_size));
+    if (!file)
+    {
+        errorlog << "Cache file for " << key << " is corrupt.\n";
+        return false;
+    }
+
+    if (indexed)
+    {
+        JSONIndexer indexer;
+        indexer.feed(answer.body);
+        answer.json_index = indexer.take_nodes();
+    }
+    entry.answer = move(answer);
+    entry.expires = system_clock::time_point{seconds{expires}};
+
+    return true;
+}
+
+void DiskCache::save(const string &key, const cache_entry &entry)
+{
+    const auto path{file_path(key)};
+    // Write into a new file and rename it, so that readers never see half a
+    // file.
+    thread_local mt19937_64 generator{random_device{}()};
+    auto temporary{path};
+    temporary += '.' + hash_hex(std::to_string(generator())) + ".tmp";
+
+    {
+        ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        const auto &answer{entry.answer};
+        file << file_magic << '\n'
+             << key << '\n'
+             << duration_cast<seconds>(entry.expires.time_since_epoch())
+                    .count()
+             << ' ' << answer.http_status << ' ' << answer.headers.size()
+             << ' ' << answer.body.size() << ' '
+             << (answer.json_index.empty() ? 0 : 1) << '\n'
+             << answer.headers << answer.body;
+        if (!file)
+        {
+            errorlog << "Could not write cache file " << temporary << '\n';
+            error_code error;
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+
+    error_code error;
+    fs::rename(temporary, path, error);
+    if (error)
+    {
+        errorlog << "Could not write cache file " << path << ": "
+                 << error.message() << '\n';
+        fs::remove(temporary, error);
+    }
+}
+
+void DiskCache::remove(const string &key)
+{
+    error_code error;
+    fs::remove(file_path(key), error);
+}
+
+string DiskCache::file_path(const string &key) const
+{
+    return (fs::path{_directory} / (hash_hex(key) + ".cache")).string();
+}
+
+} // namespace mastodonpp
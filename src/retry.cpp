@@ -0,0 +1,262 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "retry.hpp"
+
+#include "log.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::errc;
+using std::from_chars;
+using std::int64_t;
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::move;
+using std::mt19937_64;
+using std::random_device;
+using std::string;
+using std::string_view;
+using std::uniform_int_distribution;
+using std::chrono::ceil;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+namespace
+{
+
+/*!
+ *  @brief  Returns true if the request failed in a way that may go away.
+ *
+ *  @param  idempotent If false, only failures where the request was certainly
+ *                     not processed count.
+ */
+bool is_transient(const answer_type &answer, const bool idempotent)
+{
+    switch (answer.curl_error_code)
+    {
+    case CURLE_OK:
+    {
+        break;
+    }
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    {
+        return true;
+    }
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+    {
+        return idempotent;
+    }
+    default:
+    {
+        return false;
+    }
+    }
+
+    // NOLINTBEGIN(readability-magic-numbers)
+    switch (answer.http_status)
+    {
+    case 429: // Too Many Requests.
+    {
+        return true;
+    }
+    case 408: // Request Timeout.
+    case 425: // Too Early.
+    case 500: // Internal Server Error.
+    case 502: // Bad Gateway.
+    case 503: // Service Unavailable.
+    case 504: // Gateway Timeout.
+    {
+        return idempotent;
+    }
+    default:
+    {
+        return false;
+    }
+    }
+    // NOLINTEND(readability-magic-numbers)
+}
+
+//! Returns the time the server wants us to wait, or 0.
+milliseconds retry_after(const answer_type &answer)
+{
+    string_view value{answer.get_header("Retry-After")};
+    while (!value.empty() && (value.back() == '\r' || value.back() == ' '))
+    {
+        value.remove_suffix(1);
+    }
+    if (value.empty())
+    {
+        return milliseconds{0};
+    }
+
+    // Either a number of seconds or a HTTP date.
+    int64_t delay{0};
+    const auto result{
+        from_chars(value.data(), value.data() + value.size(), delay)};
+    if (result.ec == errc{} && result.ptr == value.data() + value.size())
+    {
+        return seconds{max(delay, int64_t{0})};
+    }
+
+    const time_t date{curl_getdate(string{value}.c_str(), nullptr)};
+    if (date < 0)
+    {
+        return milliseconds{0};
+    }
+    const auto wait{system_clock::from_time_t(date) - system_clock::now()};
+    return max(ceil<milliseconds>(wait), milliseconds{0});
+}
+
+} // namespace
+
+RetryBudget::RetryBudget(const retry_policy &policy)
+    : _ratio{policy.budget_ratio}
+    , _reserve{static_cast<double>(policy.budget_reserve)}
+    , _balance{_reserve}
+{}
+
+void RetryBudget::deposit()
+{
+    lock_guard<mutex> lock{_mutex};
+    ++_metrics.requests;
+    _balance = min(_balance + _ratio, _reserve);
+}
+
+bool RetryBudget::withdraw()
+{
+    lock_guard<mutex> lock{_mutex};
+    if (_balance < 1.0)
+    {
+        ++_metrics.denied;
+        return false;
+    }
+    _balance -= 1.0;
+    ++_metrics.retries;
+
+    return true;
+}
+
+retry_metrics RetryBudget::get_metrics()
+{
+    lock_guard<mutex> lock{_mutex};
+    return _metrics;
+}
+
+RetryState::RetryState(const retry_policy &policy,
+                       shared_ptr<RetryBudget> budget,
+                       const http_method method)
+    : _policy{policy}
+    , _budget{move(budget)}
+    , _method{method}
+    , _start{steady_clock::now()}
+    , _next_attempt{_start}
+{
+    _budget->deposit();
+}
+
+bool RetryState::retry(const answer_type &answer)
+{
+    if (_attempts >= _policy.max_attempts)
+    {
+        return false;
+    }
+
+    const bool idempotent{_policy.retry_non_idempotent
+                          || _method == http_method::GET
+                          || _method == http_method::PUT
+                          || _method == http_method::DELETE};
+    if (!is_transient(answer, idempotent))
+    {
+        return false;
+    }
+
+    const auto wait{max(backoff(), retry_after(answer))};
+    const auto now{steady_clock::now()};
+    if (_policy.deadline > milliseconds{0}
+        && now + wait >= _start + _policy.deadline)
+    {
+        debuglog << "Not retrying, the deadline would be exceeded.\n";
+        return false;
+    }
+    if (!_budget->withdraw())
+    {
+        debuglog << "Not retrying, the retry budget is used up.\n";
+        return false;
+    }
+
+    ++_attempts;
+    _next_attempt = now + wait;
+    debuglog << "Retrying request in " << wait.count() << " ms, attempt "
+             << _attempts << ".\n";
+
+    return true;
+}
+
+milliseconds RetryState::time_left() const noexcept
+{
+    if (_policy.deadline <= milliseconds{0})
+    {
+        return milliseconds{0};
+    }
+
+    const auto left{ceil<milliseconds>(_start + _policy.deadline
+                                       - steady_clock::now())};
+    return max(left, milliseconds{1});
+}
+
+milliseconds RetryState::backoff() const
+{
+    // Double for every attempt after the first, without overflowing.
+    milliseconds wait{_policy.initial_backoff};
+    for (size_t attempt{1}; attempt < _attempts && wait < _policy.max_backoff;
+         ++attempt)
+    {
+        wait *= 2;
+    }
+    wait = min(wait, _policy.max_backoff);
+
+    if (_policy.jitter && wait > milliseconds{0})
+    {
+        thread_local mt19937_64 generator{random_device{}()};
+        uniform_int_distribution<milliseconds::rep> distribution{0,
+                                                                 wait.count()};
+        wait = milliseconds{distribution(generator)};
+    }
+
+    return wait;
+}
+
+} // namespace mastodonpp
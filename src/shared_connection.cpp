@@ -0,0 +1,242 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared_connection.hpp"
+
+#include "log.hpp"
+
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::lock_guard;
+using std::make_shared;
+using std::make_unique;
+using std::move;
+using std::unique_lock;
+
+//! A Connection in the pool.
+struct SharedConnection::Pooled
+{
+    explicit Pooled(const Instance &instance)
+        : connection{instance}
+    {}
+
+    Connection connection;
+    //! The generation of the settings that were applied.
+    uint64_t generation{0};
+};
+
+SharedConnection::SharedConnection(const Instance &instance,
+                                   const size_t max_connections)
+    : _instance{instance}
+    , _max_connections{max_connections}
+{}
+
+SharedConnection::~SharedConnection() noexcept = default;
+
+answer_type SharedConnection::request(const http_method &method,
+                                      const endpoint_variant &endpoint,
+                                      const parametermap &parameters)
+{
+    auto pooled{borrow()};
+    auto &connection{pooled->connection};
+    try
+    {
+        answer_type answer;
+        switch (method)
+        {
+        case http_method::GET:
+        {
+            answer = connection.get(endpoint, parameters);
+            break;
+        }
+        case http_method::POST:
+        {
+            answer = connection.post(endpoint, parameters);
+            break;
+        }
+        case http_method::PATCH:
+        {
+            answer = connection.patch(endpoint, parameters);
+            break;
+        }
+        case http_method::PUT:
+        {
+            answer = connection.put(endpoint, parameters);
+            break;
+        }
+        case http_method::DELETE:
+        {
+            answer = connection.del(endpoint, parameters);
+            break;
+        }
+        }
+        give_back(move(pooled));
+        return answer;
+    }
+    catch (...)
+    {
+        give_back(move(pooled));
+        throw;
+    }
+}
+
+void SharedConnection::set_timeout(const milliseconds timeout)
+{
+    lock_guard<mutex> lock{_mutex};
+    _timeout = timeout;
+    ++_generation;
+}
+
+void SharedConnection::set_retry_policy(const retry_policy &policy)
+{
+    lock_guard<mutex> lock{_mutex};
+    _retry_policy = policy;
+    if (policy.max_attempts > 1)
+    {
+        _retry_budget = make_shared<RetryBudget>(policy);
+    }
+    else
+    {
+        _retry_budget.reset();
+    }
+    ++_generation;
+}
+
+retry_metrics SharedConnection::get_retry_metrics()
+{
+    lock_guard<mutex> lock{_mutex};
+    if (!_retry_budget)
+    {
+        return {};
+    }
+    return _retry_budget->get_metrics();
+}
+
+void SharedConnection::set_response_cache(shared_ptr<ResponseCache> cache)
+{
+    lock_guard<mutex> lock{_mutex};
+    _response_cache = move(cache);
+    ++_generation;
+}
+
+void SharedConnection::set_json_indexing(const bool enable)
+{
+    lock_guard<mutex> lock{_mutex};
+    _json_indexing = enable;
+    ++_generation;
+}
+
+size_t SharedConnection::get_connections()
+{
+    lock_guard<mutex> lock{_mutex};
+    return _connections;
+}
+
+unique_ptr<SharedConnection::Pooled> SharedConnection::borrow()
+{
+    unique_ptr<Pooled> pooled;
+    {
+        unique_lock<mutex> lock{_mutex};
+        _available.wait(lock,
+                        [this]
+                        {
+                            return !_idle.empty() || _max_connections == 0
+                                   || _connections < _max_connections;
+                        });
+        if (!_idle.empty())
+        {
+            pooled = move(_idle.back());
+            _idle.pop_back();
+        }
+        else
+        {
+            ++_connections;
+        }
+    }
+
+    try
+    {
+        if (!pooled)
+        {
+            debuglog << "Creating new pooled connection.\n";
+            pooled = make_unique<Pooled>(_instance);
+        }
+        configure(*pooled);
+    }
+    catch (...)
+    {
+        if (pooled)
+        {
+            give_back(move(pooled));
+        }
+        else
+        {
+            lock_guard<mutex> lock{_mutex};
+            --_connections;
+            _available.notify_one();
+        }
+        throw;
+    }
+
+    return pooled;
+}
+
+void SharedConnection::give_back(unique_ptr<Pooled> pooled)
+{
+    {
+        lock_guard<mutex> lock{_mutex};
+        _idle.push_back(move(pooled));
+    }
+    _available.notify_one();
+}
+
+void SharedConnection::configure(Pooled &pooled)
+{
+    uint64_t generation{0};
+    milliseconds timeout{0};
+    optional<retry_policy> policy;
+    shared_ptr<RetryBudget> budget;
+    shared_ptr<ResponseCache> cache;
+    bool json_indexing{false};
+    {
+        lock_guard<mutex> lock{_mutex};
+        generation = _generation;
+        if (pooled.generation == generation)
+        {
+            return;
+        }
+        timeout = _timeout;
+        policy = _retry_policy;
+        budget = _retry_budget;
+        cache = _response_cache;
+        json_indexing = _json_indexing;
+    }
+
+    auto &connection{pooled.connection};
+    connection.set_timeout(timeout);
+    if (policy)
+    {
+        connection.set_retry_policy(*policy, move(budget));
+    }
+    connection.set_response_cache(move(cache));
+    connection.set_json_indexing(json_indexing);
+    pooled.generation = generation;
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,95 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "single_flight.hpp"
+
+#include "log.hpp"
+
+#include <exception>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::current_exception;
+using std::lock_guard;
+using std::make_shared;
+using std::move;
+using std::promise;
+
+shared_ptr<SingleFlight> SingleFlight::get()
+{
+    static const auto single_flight{make_shared<SingleFlight>()};
+    return single_flight;
+}
+
+answer_type SingleFlight::run(const string &key,
+                              const function<answer_type()> &request)
+{
+    promise<answer_type> answer_promise;
+    shared_future<answer_type> identical;
+    {
+        lock_guard<mutex> lock{_mutex};
+        const auto it{_running.find(key)};
+        if (it != _running.end())
+        {
+            identical = it->second;
+        }
+        else
+        {
+            _running.emplace(key, answer_promise.get_future().share());
+        }
+    }
+    if (identical.valid())
+    {
+        ++_shared;
+        debuglog << "Waiting for identical request: " << key << '\n';
+        return identical.get();
+    }
+    ++_sent;
+
+    // Remove the entry before the waiting callers are woken up, so that
+    // callers coming after the answer make a new request.
+    const auto finish{[this, &key]
+                      {
+                          lock_guard<mutex> lock{_mutex};
+                          _running.erase(key);
+                      }};
+    try
+    {
+        auto answer{request()};
+        finish();
+        answer_promise.set_value(answer);
+        return answer;
+    }
+    catch (...)
+    {
+        finish();
+        answer_promise.set_exception(current_exception());
+        throw;
+    }
+}
+
+single_flight_metrics SingleFlight::get_metrics() const noexcept
+{
+    single_flight_metrics metrics;
+    metrics.sent = _sent;
+    metrics.shared = _shared;
+
+    return metrics;
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,122 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_SPSC_QUEUE_HPP
+#define MASTODONPP_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::size_t;
+using std::vector;
+
+/*!
+ *  @brief  Lock-free ring buffer for exactly one producer and one consumer
+ *          thread.
+ *
+ *  Neither side ever waits for the other: push() fails if the queue is full
+ *  and pop() fails if it is empty.
+ *
+ *  @since  0.6.0
+ */
+template <typename T>
+class SPSCQueue
+{
+public:
+    /*!
+     *  @brief  Constructs a queue.
+     *
+     *  @param  capacity Is rounded up to the next power of 2.
+     *
+     *  @since  0.6.0
+     */
+    explicit SPSCQueue(const size_t capacity)
+        : _slots(round_up(capacity))
+        , _mask{_slots.size() - 1}
+    {}
+
+    /*!
+     *  @brief  Append an element. Only call this from the producer thread.
+     *
+     *  @return false if the queue is full. The value is not moved from then.
+     *
+     *  @since  0.6.0
+     */
+    bool push(T &&value)
+    {
+        const size_t tail{_tail.load(memory_order_relaxed)};
+        if (tail - _head.load(memory_order_acquire) == _slots.size())
+        {
+            return false;
+        }
+
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    /*!
+     *  @brief  Take the oldest element. Only call this from the consumer
+     *          thread.
+     *
+     *  @return false if the queue is empty.
+     *
+     *  @since  0.6.0
+     */
+    bool pop(T &value)
+    {
+        const size_t head{_head.load(memory_order_relaxed)};
+        if (head == _tail.load(memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = std::move(_slots[head & _mask]);
+        _head.store(head + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    vector<T> _slots;
+    const size_t _mask;
+    // Separate cache lines, so that producer and consumer don't fight over
+    // them.
+    alignas(64) atomic<size_t> _head{0};
+    alignas(64) atomic<size_t> _tail{0};
+
+    static size_t round_up(const size_t capacity)
+    {
+        size_t size{1};
+        while (size < capacity)
+        {
+            size <<= 1U;
+        }
+        return size;
+    }
+};
+
+} // namespace mastodonpp
+
+#endif // MASTODONPP_SPSC_QUEUE_HPP
@@ -0,0 +1,158 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sse_parser.hpp"
+
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::move;
+
+size_t SSEParser::feed(string_view data, vector<event_type> &events)
+{
+    size_t appended{0};
+
+    // A “\r\n” can be split between 2 chunks.
+    if (_skip_lf && !data.empty() && data[0] == '\n')
+    {
+        data.remove_prefix(1);
+    }
+    _skip_lf = false;
+
+    while (!data.empty())
+    {
+        const auto pos{data.find_first_of("\r\n")};
+        if (pos == string_view::npos)
+        {
+            _line.append(data);
+            break;
+        }
+
+        // Complete lines are processed without copying them.
+        bool added{false};
+        if (_line.empty())
+        {
+            added = process_line(data.substr(0, pos), events);
+        }
+        else
+        {
+            _line.append(data.substr(0, pos));
+            added = process_line(_line, events);
+            _line.clear();
+        }
+        if (added)
+        {
+            ++appended;
+        }
+
+        if (data[pos] == '\r')
+        {
+            if (pos + 1 == data.size())
+            {
+                _skip_lf = true;
+            }
+            else if (data[pos + 1] == '\n')
+            {
+                data.remove_prefix(1);
+            }
+        }
+        data.remove_prefix(pos + 1);
+    }
+
+    return appended;
+}
+
+void SSEParser::reset()
+{
+    _line.clear();
+    _type.clear();
+    _data.clear();
+    _id.clear();
+    _has_data = false;
+    _skip_lf = false;
+    _comments = 0;
+}
+
+bool SSEParser::process_line(const string_view line,
+                             vector<event_type> &events)
+{
+    // An empty line dispatches the event.
+    if (line.empty())
+    {
+        if (!_has_data)
+        {
+            _type.clear();
+            return false;
+        }
+
+        event_type event;
+        event.type = _type.empty() ? "message" : move(_type);
+        event.data = move(_data);
+        event.id = _id;
+        events.push_back(move(event));
+
+        _type.clear();
+        _data.clear();
+        _has_data = false;
+        return true;
+    }
+
+    if (line[0] == ':')
+    {
+        ++_comments;
+        return false;
+    }
+
+    const auto colon{line.find(':')};
+    const string_view field{line.substr(0, colon)};
+    string_view value;
+    if (colon != string_view::npos)
+    {
+        value = line.substr(colon + 1);
+        if (!value.empty() && value[0] == ' ')
+        {
+            value.remove_prefix(1);
+        }
+    }
+
+    if (field == "data")
+    {
+        if (_has_data)
+        {
+            _data += '\n';
+        }
+        _data.append(value);
+        _has_data = true;
+    }
+    else if (field == "event")
+    {
+        _type = value;
+    }
+    else if (field == "id")
+    {
+        if (value.find('\0') == string_view::npos)
+        {
+            _id = value;
+        }
+    }
+    // Other fields, like “retry”, are ignored.
+
+    return false;
+}
+
+} // namespace mastodonpp
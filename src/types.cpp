@@ -45,7 +45,7 @@ std::ostream &operator<<(std::ostream &out, const answer_type &answer)
 
 string_view answer_type::get_header(const string_view field) const
 {
-    const string_view searchstring{string(field) += ':'};
+    const string searchstring{string(field) += ':'};
     // clang-format off
     auto it{search(headers.begin(), headers.end(), searchstring.begin(),
                    searchstring.end(), [](unsigned char a, unsigned char b)
@@ -73,6 +73,10 @@ parametermap answer_type::parse_pagination(const bool next) const
 
     const string_view direction{next ? R"(rel="next")" : R"(rel="prev")"};
     auto endpos{link.find(direction)};
+    if (endpos == string_view::npos)
+    {
+        return {};
+    }
     endpos = link.rfind('>', endpos);
     auto startpos{link.rfind('?', endpos) + 1};
     const string_view paramstr{link.substr(startpos, endpos - startpos)};
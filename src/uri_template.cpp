@@ -0,0 +1,104 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "uri_template.hpp"
+
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace mastodonpp
+{
+
+using std::array;
+using std::equal;
+using std::find_if;
+using std::get;
+using std::holds_alternative;
+using std::tolower;
+
+namespace
+{
+
+bool equal_case_insensitive(const string_view a, const string_view b) noexcept
+{
+    return equal(a.begin(), a.end(), b.begin(), b.end(),
+                 [](const unsigned char c1, const unsigned char c2)
+                 { return tolower(c1) == tolower(c2); });
+}
+
+} // namespace
+
+void URITemplate::render(const parametermap &parameters, string &uri) const
+{
+    // Look up the values first, so that the size is known.
+    array<string_view, endpoint_path::max_placeholders> values;
+    size_t size{_baseuri.size() + _path.path.size()};
+    for (size_t index{0}; index < _path.placeholders_size; ++index)
+    {
+        const string_view name{placeholder_name(index)};
+        const auto param{
+            find_if(parameters.begin(), parameters.end(),
+                    [name](const auto &p)
+                    { return equal_case_insensitive(p.first, name); })};
+        if (param == parameters.end()
+            || !holds_alternative<string_view>(param->second))
+        {
+            string message{"Parameter missing for <"};
+            ((message += name) += "> in ") += _path.path;
+            throw CURLException{CURLE_URL_MALFORMAT, message};
+        }
+        values[index] = get<string_view>(param->second);
+        size += values[index].size();
+        size -= _path.placeholders[index].size;
+    }
+
+    uri.clear();
+    uri.reserve(size);
+    uri += _baseuri;
+    size_t pos{0};
+    for (size_t index{0}; index < _path.placeholders_size; ++index)
+    {
+        const auto &placeholder{_path.placeholders[index]};
+        uri.append(_path.path.substr(pos, placeholder.position - pos));
+        uri += values[index];
+        pos = placeholder.position + placeholder.size;
+    }
+    uri.append(_path.path.substr(pos));
+}
+
+bool URITemplate::binds(const string_view name) const noexcept
+{
+    for (size_t index{0}; index < _path.placeholders_size; ++index)
+    {
+        if (equal_case_insensitive(name, placeholder_name(index)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+string_view URITemplate::placeholder_name(const size_t index) const noexcept
+{
+    const auto &placeholder{_path.placeholders[index]};
+    return _path.path.substr(placeholder.position + 1, placeholder.size - 2);
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,409 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "websocket_stream.hpp"
+
+#include "exceptions.hpp"
+#include "log.hpp"
+
+#include <poll.h>
+
+#include <array>
+#include <cstdio>
+#include <utility>
+
+namespace mastodonpp
+{
+
+using std::array;
+using std::make_shared;
+using std::move;
+using std::snprintf;
+
+namespace
+{
+
+//! Append @a text as JSON string, including the quotes.
+void append_json_string(string &out, const string_view text)
+{
+    out += '"';
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) // NOLINT
+        {
+            array<char, 7> escaped{};
+            snprintf(escaped.data(), escaped.size(), "\\u%04x", c);
+            out += escaped.data();
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+#if (LIBCURL_VERSION_NUM >= 0x075600) // libcurl >= 7.86.0.
+//! The frame pointer of curl_ws_recv() became const in later versions.
+template <typename Frame>
+CURLcode ws_recv(CURLcode (*function)(CURL *, void *, size_t, size_t *,
+                                      Frame **),
+                 CURL *handle, void *buffer, const size_t size,
+                 size_t *received, const curl_ws_frame *&meta)
+{
+    Frame *frame{nullptr};
+    const CURLcode code{function(handle, buffer, size, received, &frame)};
+    meta = frame;
+    return code;
+}
+#endif
+
+} // namespace
+
+WebSocketStream::WebSocketStream(const Instance &instance)
+    : CURLWrapper{instance.get_hostname()}
+    , _instance{instance}
+{
+    _instance.copy_connection_properties(*this);
+}
+
+WebSocketStream::~WebSocketStream() noexcept
+{
+    close();
+}
+
+answer_type WebSocketStream::connect()
+{
+    return connect(string("wss://") += string(_instance.get_hostname())
+                   += "/api/v1/streaming");
+}
+
+answer_type WebSocketStream::connect(const string_view uri)
+{
+    close();
+    _message.clear();
+
+    auto answer{handshake(uri)};
+    _connected = (answer.curl_error_code == 0 && answer.http_status == 101);
+    debuglog << "WebSocket " << (_connected ? "connected" : "not connected")
+             << " to " << uri << '\n';
+
+    for (const auto &subscription : _subscriptions)
+    {
+        send_subscription("subscribe", subscription.first);
+    }
+
+    return answer;
+}
+
+void WebSocketStream::close()
+{
+    if (!_connected)
+    {
+        return;
+    }
+
+    send_close();
+    _connected = false;
+    debuglog << "WebSocket closed.\n";
+}
+
+void WebSocketStream::subscribe(const string_view stream,
+                                const string_view parameter,
+                                event_callback callback)
+{
+    stream_key key{stream, parameter};
+    auto &subscription{_subscriptions[key]};
+    const bool is_new{!subscription};
+    subscription = make_shared<event_callback>(move(callback));
+
+    if (is_new)
+    {
+        send_subscription("subscribe", key);
+    }
+}
+
+void WebSocketStream::unsubscribe(const string_view stream,
+                                  const string_view parameter)
+{
+    const stream_key key{stream, parameter};
+    if (_subscriptions.erase(key) > 0)
+    {
+        send_subscription("unsubscribe", key);
+    }
+}
+
+size_t WebSocketStream::poll(const milliseconds timeout)
+{
+    constexpr size_t buffer_size{16384};
+    array<char, buffer_size> buffer{};
+    size_t delivered{0};
+    bool waited{false};
+
+    while (_connected)
+    {
+        frame_part part;
+        const CURLcode code{receive(buffer.data(), buffer.size(), part)};
+        if (code == CURLE_AGAIN)
+        {
+            if (delivered > 0 || waited || !wait_for_socket(false, timeout))
+            {
+                break;
+            }
+            waited = true;
+            continue;
+        }
+        if (code != CURLE_OK)
+        {
+            debuglog << "WebSocket error: " << curl_easy_strerror(code) << '\n';
+            _connected = false;
+            break;
+        }
+
+        if (part.type == frame_type::close)
+        {
+            debuglog << "WebSocket closed by server.\n";
+            _connected = false;
+            break;
+        }
+        if (part.type == frame_type::control)
+        {
+            continue;
+        }
+
+        // Messages can arrive in several frames and frames in several parts.
+        _message.append(buffer.data(), part.size);
+        if (part.last)
+        {
+            const string message{move(_message)};
+            _message.clear();
+            if (dispatch(message))
+            {
+                ++delivered;
+            }
+        }
+    }
+
+    return delivered;
+}
+
+void WebSocketStream::send_subscription(const string_view type,
+                                        const stream_key &key)
+{
+    if (!_connected)
+    {
+        return;
+    }
+
+    string message{R"({"type":)"};
+    append_json_string(message, type);
+    message += R"(,"stream":)";
+    append_json_string(message, key.first);
+    if (!key.second.empty())
+    {
+        message += (key.first == "list") ? R"(,"list":)" : R"(,"tag":)";
+        append_json_string(message, key.second);
+    }
+    message += '}';
+
+    send(message);
+}
+
+void WebSocketStream::send(const string_view text)
+{
+    constexpr milliseconds send_timeout{10000};
+    size_t offset{0};
+    while (_connected && offset < text.size())
+    {
+        size_t sent{0};
+        const CURLcode code{send_text(text.substr(offset), sent)};
+        offset += sent;
+        if (code == CURLE_AGAIN)
+        {
+            if (!wait_for_socket(true, send_timeout))
+            {
+                debuglog << "WebSocket send timed out.\n";
+                _connected = false;
+            }
+            continue;
+        }
+        if (code != CURLE_OK)
+        {
+            debuglog << "WebSocket error: " << curl_easy_strerror(code) << '\n';
+            _connected = false;
+        }
+    }
+}
+
+bool WebSocketStream::dispatch(const string_view message)
+{
+    // Messages look like this: {"stream":["hashtag","foo"],"event":"update",
+    // "payload":"{…}"}. Errors look like this: {"error":"…","status":400}
+    _indexer.feed(message);
+    const auto nodes{_indexer.take_nodes()};
+    const JSONValue json{message, nodes};
+    const auto stream{json["stream"]};
+    stream_key key;
+    if (stream.type() == json_type::array)
+    {
+        key.first = stream[0].get_string();
+        key.second = stream[1].get_string();
+    }
+    else
+    {
+        key.first = stream.get_string();
+    }
+    if (key.first.empty())
+    {
+        debuglog << "Unexpected WebSocket message: " << message << '\n';
+        return false;
+    }
+
+    const auto it{_subscriptions.find(key)};
+    if (it == _subscriptions.end())
+    {
+        debuglog << "Event for unknown stream: " << key.first << '\n';
+        return false;
+    }
+
+    // The callback may unsubscribe and thereby destroy itself.
+    const auto callback{it->second};
+    event_type event;
+    event.type = json["event"].get_string();
+    // Some events have an object as payload instead of a string.
+    const auto payload{json["payload"]};
+    if (payload.type() == json_type::text)
+    {
+        event.data = payload.get_string();
+    }
+    else
+    {
+        event.data = payload.raw();
+    }
+    if (!(*callback)(move(event)))
+    {
+        const auto current{_subscriptions.find(key)};
+        if (current != _subscriptions.end() && current->second == callback)
+        {
+            unsubscribe(key.first, key.second);
+        }
+    }
+
+    return true;
+}
+
+answer_type WebSocketStream::handshake(const string_view uri)
+{
+#if (LIBCURL_VERSION_NUM >= 0x075600) // libcurl >= 7.86.0.
+    prepare_request(http_method::GET, URITemplate::literal(uri), {});
+    // Do the handshake, then leave the socket to curl_ws_recv/curl_ws_send.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const CURLcode code{
+        curl_easy_setopt(get_curl_easy_handle(), CURLOPT_CONNECT_ONLY, 2L)};
+    if (code != CURLE_OK)
+    {
+        throw CURLException{code, "Failed to enable WebSocket mode."};
+    }
+
+    return finish_request(curl_easy_perform(get_curl_easy_handle()));
+#else
+    static_cast<void>(uri);
+    throw CURLException{CURLE_NOT_BUILT_IN,
+                        "WebSockets need libcurl 7.86.0 or newer."};
+#endif
+}
+
+CURLcode WebSocketStream::receive(char *buffer, const size_t size,
+                                  frame_part &part)
+{
+#if (LIBCURL_VERSION_NUM >= 0x075600) // libcurl >= 7.86.0.
+    const curl_ws_frame *meta{nullptr};
+    const CURLcode code{ws_recv(curl_ws_recv, get_curl_easy_handle(), buffer,
+                                size, &part.size, meta)};
+    if (code != CURLE_OK)
+    {
+        return code;
+    }
+
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    if ((meta->flags & CURLWS_CLOSE) != 0)
+    {
+        part.type = frame_type::close;
+    }
+    // Pings are answered by libcurl.
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    else if ((meta->flags & (CURLWS_PING | CURLWS_PONG)) != 0)
+    {
+        part.type = frame_type::control;
+    }
+    else
+    {
+        part.type = frame_type::data;
+    }
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    part.last = (meta->bytesleft == 0 && (meta->flags & CURLWS_CONT) == 0);
+
+    return CURLE_OK;
+#else
+    static_cast<void>(buffer);
+    static_cast<void>(size);
+    static_cast<void>(part);
+    return CURLE_NOT_BUILT_IN;
+#endif
+}
+
+CURLcode WebSocketStream::send_text(const string_view text, size_t &sent)
+{
+#if (LIBCURL_VERSION_NUM >= 0x075600) // libcurl >= 7.86.0.
+    return curl_ws_send(get_curl_easy_handle(), text.data(), text.size(),
+                        &sent, 0, CURLWS_TEXT);
+#else
+    static_cast<void>(text);
+    static_cast<void>(sent);
+    return CURLE_NOT_BUILT_IN;
+#endif
+}
+
+void WebSocketStream::send_close()
+{
+#if (LIBCURL_VERSION_NUM >= 0x075600) // libcurl >= 7.86.0.
+    size_t sent{0};
+    curl_ws_send(get_curl_easy_handle(), "", 0, &sent, 0, CURLWS_CLOSE);
+#endif
+}
+
+bool WebSocketStream::wait_for_socket(const bool write,
+                                      const milliseconds timeout)
+{
+    curl_socket_t socket{CURL_SOCKET_BAD};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    curl_easy_getinfo(get_curl_easy_handle(), CURLINFO_ACTIVESOCKET, &socket);
+    if (socket == CURL_SOCKET_BAD)
+    {
+        _connected = false;
+        return false;
+    }
+
+    pollfd descriptor{socket, static_cast<short>(write ? POLLOUT : POLLIN), 0};
+    return ::poll(&descriptor, 1, static_cast<int>(timeout.count())) > 0;
+}
+
+} // namespace mastodonpp
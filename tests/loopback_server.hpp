@@ -0,0 +1,164 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTODONPP_TESTS_LOOPBACK_SERVER_HPP
+#define MASTODONPP_TESTS_LOOPBACK_SERVER_HPP
+
+// Tests that need a server on the loopback interface are only built where
+// BSD sockets are available, so not with MinGW.
+#if __has_include(<sys/socket.h>)
+#    define MASTODONPP_HAVE_LOOPBACK_SERVER
+
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+
+#    include <cstddef>
+#    include <string>
+#    include <string_view>
+#    include <thread>
+#    include <vector>
+
+namespace mastodonpp
+{
+
+/*!
+ *  @brief  A HTTP server on 127.0.0.1 that answers a number of requests
+ *          with 200 and records them.
+ *
+ *  With 0 answers, connections are accepted by the kernel but never
+ *  answered, so requests hang until they are aborted.
+ */
+class LoopbackServer
+{
+public:
+    explicit LoopbackServer(const std::size_t answers)
+        : _socket{::socket(AF_INET, SOCK_STREAM, 0)}
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size{sizeof(address)};
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+        ::bind(_socket, reinterpret_cast<sockaddr *>(&address), size);
+        ::listen(_socket, 1);
+        ::getsockname(_socket, reinterpret_cast<sockaddr *>(&address), &size);
+        // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+        _hostname = "127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+        _uri = "http://" + _hostname + "/api/v1/statuses";
+        if (answers > 0)
+        {
+            _thread = std::thread{[this, answers] { serve(answers); }};
+        }
+    }
+
+    LoopbackServer(const LoopbackServer &other) = delete;
+    LoopbackServer(LoopbackServer &&other) noexcept = delete;
+    LoopbackServer &operator=(const LoopbackServer &other) = delete;
+    LoopbackServer &operator=(LoopbackServer &&other) noexcept = delete;
+
+    ~LoopbackServer()
+    {
+        ::shutdown(_socket, SHUT_RDWR);
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+        ::close(_socket);
+    }
+
+    //! Returns “127.0.0.1:port”, for an Instance.
+    [[nodiscard]] std::string_view hostname() const
+    {
+        return _hostname;
+    }
+
+    //! Returns a `http://` URI on the server.
+    [[nodiscard]] std::string_view uri() const
+    {
+        return _uri;
+    }
+
+    //! Returns the requests, headers and body. Call after the last request.
+    [[nodiscard]] const std::vector<std::string> &requests()
+    {
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+        return _requests;
+    }
+
+private:
+    int _socket;
+    std::string _hostname;
+    std::string _uri;
+    std::vector<std::string> _requests;
+    std::thread _thread;
+
+    void serve(std::size_t answers)
+    {
+        for (; answers > 0; --answers)
+        {
+            const int client{::accept(_socket, nullptr, nullptr)};
+            if (client < 0)
+            {
+                return;
+            }
+            _requests.push_back(receive(client));
+            constexpr std::string_view response{"HTTP/1.1 200 OK\r\n"
+                                                "Content-Length: 0\r\n"
+                                                "Connection: close\r\n\r\n"};
+            ::send(client, response.data(), response.size(), 0);
+            ::close(client);
+        }
+    }
+
+    //! Read the header and as much of the body as Content-Length says.
+    static std::string receive(const int client)
+    {
+        std::string request;
+        std::size_t expected{std::string::npos};
+        while (request.size() < expected)
+        {
+            char buffer[4096]; // NOLINT(modernize-avoid-c-arrays)
+            const auto received{::recv(client, buffer, sizeof(buffer), 0)};
+            if (received <= 0)
+            {
+                break;
+            }
+            request.append(buffer, static_cast<std::size_t>(received));
+
+            const auto end{request.find("\r\n\r\n")};
+            if (expected == std::string::npos && end != std::string::npos)
+            {
+                const auto length{request.find("Content-Length: ")};
+                expected = end + 4;
+                if (length != std::string::npos && length < end)
+                {
+                    expected += std::stoul(request.substr(length + 16));
+                }
+            }
+        }
+        return request;
+    }
+};
+
+} // namespace mastodonpp
+
+#endif // __has_include(<sys/socket.h>)
+
+#endif // MASTODONPP_TESTS_LOOPBACK_SERVER_HPP
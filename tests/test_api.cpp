@@ -0,0 +1,56 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020, 2022 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "api.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+namespace mastodonpp
+{
+
+// The paths are resolved at compile time.
+static_assert(API{API::v1::accounts_id_followers}.to_string_view()
+              == "/api/v1/accounts/<ID>/followers");
+static_assert(API{API::v2::media}.to_string_view() == "/api/v2/media");
+static_assert(API{API::pleroma::account_register}.to_string_view()
+              == "/api/pleroma/account/register");
+
+SCENARIO("mastodonpp::API.")
+{
+    WHEN("The path of an endpoint with 2 placeholders is looked up.")
+    {
+        const API api{API::pleroma::admin_reports_report_id_notes_id};
+        const auto &path{api.get_path()};
+
+        THEN("Both placeholders are found.")
+        {
+            REQUIRE(path.placeholders_size == 2);
+            REQUIRE(path.path.substr(path.placeholders[0].position,
+                                     path.placeholders[0].size)
+                    == "<REPORT_ID>");
+            REQUIRE(path.path.substr(path.placeholders[1].position,
+                                     path.placeholders[1].size)
+                    == "<ID>");
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -15,7 +15,11 @@
  */
 
 #include "connection.hpp"
+#include "exceptions.hpp"
 #include "instance.hpp"
+#include "loopback_server.hpp"
+#include "types.hpp"
+#include "uri_template.hpp"
 
 // catch 3 does not have catch.hpp anymore
 #if __has_include(<catch.hpp>)
@@ -24,11 +28,40 @@
 #    include <catch_all.hpp>
 #endif
 
+#include <chrono>
 #include <exception>
+#include <string>
+#include <vector>
 
 namespace mastodonpp
 {
 
+using std::string;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::vector;
+
+namespace
+{
+
+//! Sends requests to a URI instead of the Instance.
+class LoopbackConnection : public Connection
+{
+public:
+    using Connection::Connection;
+    using Connection::make_request;
+
+    answer_type send(const http_method &method, const string_view uri,
+                     const parametermap &parameters)
+    {
+        prepare_request(method, URITemplate{uri}, parameters);
+        return finish_request(curl_easy_perform(get_curl_easy_handle()));
+    }
+};
+
+} // namespace
+
 SCENARIO("mastodonpp::Connection.")
 {
     bool exception = false;
@@ -50,6 +83,117 @@ SCENARIO("mastodonpp::Connection.")
             REQUIRE_FALSE(exception);
         }
     }
+
+    WHEN("A string endpoint has an unclosed placeholder.")
+    {
+        CURLcode code{CURLE_OK};
+        try
+        {
+            Instance instance{"mastodonpp.invalid", {}};
+            Connection connection{instance};
+            static_cast<void>(
+                connection.get("/api/v1/statuses/<ID", {{"ID", "1"}}));
+        }
+        catch (const CURLException &e)
+        {
+            code = e.error_code;
+        }
+
+        THEN("A CURLException with CURLE_URL_MALFORMAT is thrown.")
+        {
+            REQUIRE(code == CURLE_URL_MALFORMAT);
+        }
+    }
+}
+
+SCENARIO("mastodonpp::CURLWrapper requests full URIs as they are.")
+{
+    WHEN("The URIs contain angle brackets.")
+    {
+        bool exception{false};
+        vector<answer_type> answers;
+        try
+        {
+            // Fails without network access.
+            Instance instance{"mastodonpp.invalid", {}};
+            LoopbackConnection connection{instance};
+            for (const string uri : {"https://mastodonpp.invalid/<unclosed",
+                                     "https://mastodonpp.invalid/<X>/info"})
+            {
+                answers.push_back(
+                    connection.make_request(http_method::GET, uri, {}));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("The requests are made.")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE(answers.size() == 2);
+            for (const auto &answer : answers)
+            {
+                REQUIRE(answer.curl_error_code == CURLE_COULDNT_RESOLVE_HOST);
+            }
+        }
+    }
+}
+
+#ifdef MASTODONPP_HAVE_LOOPBACK_SERVER
+SCENARIO("mastodonpp::Connection sends the right method.")
+{
+    WHEN("A DELETE request is followed by a POST request.")
+    {
+        LoopbackServer server{2};
+        Instance instance{"example.com", {}};
+        LoopbackConnection connection{instance};
+        const auto deleted{
+            connection.send(http_method::DELETE, server.uri(), {})};
+        const auto posted{connection.send(http_method::POST, server.uri(),
+                                          {{"status", "a b&c"}})};
+        const auto &requests{server.requests()};
+
+        THEN("The POST request is sent as POST with an urlencoded body.")
+        {
+            REQUIRE(deleted.http_status == 200);
+            REQUIRE(posted.http_status == 200);
+            REQUIRE(requests.size() == 2);
+            REQUIRE(requests[0].rfind("DELETE /api/v1/statuses ", 0) == 0);
+            REQUIRE(requests[1].rfind("POST /api/v1/statuses ", 0) == 0);
+            REQUIRE(requests[1].find(
+                        "Content-Type: application/x-www-form-urlencoded")
+                    != string::npos);
+            REQUIRE(requests[1].substr(requests[1].find("\r\n\r\n") + 4)
+                    == "status=a%20b%26c");
+        }
+    }
+}
+
+SCENARIO("mastodonpp::Connection keeps the timeout when copied.")
+{
+    WHEN("A copy of a Connection with a timeout requests a hanging server.")
+    {
+        LoopbackServer server{0};
+        Instance instance{server.hostname(), {}};
+        Connection connection{instance};
+        connection.set_timeout(milliseconds{200});
+        Connection copy{connection};
+
+        const auto before{steady_clock::now()};
+        const auto answer{copy.get("/api/v1/timelines/home")};
+        const auto duration{steady_clock::now() - before};
+
+        THEN("The request times out.")
+        {
+            REQUIRE(answer.curl_error_code == CURLE_OPERATION_TIMEDOUT);
+            REQUIRE(duration < seconds{5});
+        }
+    }
 }
 
+#endif // MASTODONPP_HAVE_LOOPBACK_SERVER
+
 } // namespace mastodonpp
@@ -0,0 +1,123 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "api.hpp"
+#include "dispatcher.hpp"
+#include "instance.hpp"
+#include "loopback_server.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::string;
+using std::vector;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+SCENARIO("mastodonpp::Dispatcher")
+{
+    // Fails without network access.
+    Instance instance{"mastodonpp.invalid", {}};
+
+    WHEN("A request to an unresolvable host is submitted.")
+    {
+        Dispatcher dispatcher{instance};
+        auto answer{dispatcher.submit(http_method::GET, API::v1::instance, {})};
+        const auto status{answer.wait_for(seconds{10})};
+
+        THEN("The future becomes ready with the curl error.")
+        {
+            REQUIRE(status == std::future_status::ready);
+            REQUIRE(answer.get().curl_error_code
+                    == CURLE_COULDNT_RESOLVE_HOST);
+            REQUIRE(dispatcher.get_active_requests() == 0);
+        }
+    }
+
+    WHEN("A request is submitted with a delay.")
+    {
+        Dispatcher dispatcher{instance};
+        promise<steady_clock::time_point> finished;
+        const auto before{steady_clock::now()};
+        dispatcher.submit_after(milliseconds{200}, http_method::GET,
+                                API::v1::instance, {},
+                                [&finished](answer_type)
+                                { finished.set_value(steady_clock::now()); });
+        auto after{finished.get_future()};
+        const auto status{after.wait_for(seconds{10})};
+
+        THEN("It starts after the delay.")
+        {
+            REQUIRE(status == std::future_status::ready);
+            REQUIRE(after.get() - before >= milliseconds{200});
+        }
+    }
+
+#ifdef MASTODONPP_HAVE_LOOPBACK_SERVER
+    WHEN("The Dispatcher is destroyed with unfinished requests.")
+    {
+        LoopbackServer server{0};
+        Instance hanging{server.hostname(), {}};
+
+        mutex answers_mutex;
+        vector<answer_type> answers;
+        const auto collect{[&answers_mutex, &answers](answer_type answer)
+                           {
+                               lock_guard<mutex> lock{answers_mutex};
+                               answers.push_back(std::move(answer));
+                           }};
+        {
+            Dispatcher dispatcher{hanging};
+            dispatcher.submit(http_method::GET, API::v1::instance, {}, collect);
+            dispatcher.submit_after(hours{1}, http_method::GET,
+                                    API::v1::instance, {}, collect);
+            std::this_thread::sleep_for(milliseconds{100});
+            dispatcher.submit(http_method::GET, API::v1::instance, {}, collect);
+        }
+
+        THEN("Every callback is called with CURLE_ABORTED_BY_CALLBACK.")
+        {
+            REQUIRE(answers.size() == 3);
+            for (const auto &answer : answers)
+            {
+                REQUIRE(answer.curl_error_code == CURLE_ABORTED_BY_CALLBACK);
+            }
+        }
+    }
+#endif // MASTODONPP_HAVE_LOOPBACK_SERVER
+}
+
+} // namespace mastodonpp
@@ -25,11 +25,15 @@
 
 #include <exception>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace mastodonpp
 {
 
 using std::string;
+using std::string_view;
+using std::vector;
 
 SCENARIO("mastodonpp::html_unescape()")
 {
@@ -54,6 +58,61 @@ SCENARIO("mastodonpp::html_unescape()")
             REQUIRE(result == "2€ = 2€ = 2€");
         }
     }
+
+    WHEN("The HTML contains unknown or broken entities.")
+    {
+        const string html{"&lt;p&gt;&amp;lt; &unknown; &#xD800; &#12a; &amp"
+                          "&zwnj&AElig;&#x1F600;&#128512;&;"};
+        const string expected{"<p>&lt; &unknown; &#xD800; &#12a; &amp"
+                              "&zwnjÆ😀😀&;"};
+        string in_place{html};
+        unescape_html_in_place(in_place);
+        string appended{"x"};
+        unescape_html(html, appended);
+
+        THEN("Only valid entities are replaced, once.")
+        AND_THEN("All variants return the same result.")
+        {
+            REQUIRE(unescape_html(html) == expected);
+            REQUIRE(in_place == expected);
+            REQUIRE(appended == "x" + expected);
+        }
+    }
+}
+
+SCENARIO("mastodonpp::html_to_text()")
+{
+    const vector<string_view> html{
+        R"(<p>Hi <span class="h-card"><a href="https://example.com/@user" )"
+        R"(class="u-url mention">@<span>user</span></a></span>!</p><p>)"
+        R"(<a href="https://example.com/very/long/path" rel="nofollow">)"
+        R"(<span class="invisible">https://</span><span class="ellipsis">)"
+        R"(example.com/very</span><span class="invisible">/long/path</span>)"
+        R"(</a> &amp; <a href="https://example.com/tags/tag" )"
+        R"(class="mention hashtag">#<span>tag</span></a></p>)",
+        "Pleroma<br/>uses<BR>br &lt;3",
+        "",
+        "broken <tag"};
+
+    WHEN("A batch is converted.")
+    {
+        string arena;
+        vector<string_view> texts;
+        html_to_text(html, arena, texts);
+
+        THEN("Tags are removed and entities replaced.")
+        AND_THEN("Mentions, hashtags and links are complete.")
+        {
+            REQUIRE(texts.size() == 4);
+            REQUIRE(texts[0]
+                    == "Hi @user!\n\nhttps://example.com/very/long/path & "
+                       "#tag");
+            REQUIRE(texts[1] == "Pleroma\nuses\nbr <3");
+            REQUIRE(texts[2].empty());
+            REQUIRE(texts[3] == "broken <tag");
+            REQUIRE(html_to_text(html[1]) == texts[1]);
+        }
+    }
 }
 
 } // namespace mastodonpp
@@ -0,0 +1,161 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance_registry.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <string>
+
+namespace mastodonpp
+{
+
+using std::string;
+
+SCENARIO("mastodonpp::InstanceRegistry")
+{
+    InstanceRegistry registry;
+    string value;
+
+    WHEN("The registry is not enabled.")
+    {
+        registry.store("example.com", "nodeinfo", "{}");
+
+        THEN("Nothing is stored.")
+        {
+            REQUIRE_FALSE(registry.lookup("example.com", "nodeinfo", value));
+        }
+    }
+
+    registry.set_ttl(std::chrono::hours{1});
+
+    WHEN("Metadata is stored.")
+    {
+        registry.store("example.com", "nodeinfo", "{}");
+
+        THEN("It is found for the same hostname and field only.")
+        {
+            REQUIRE(registry.lookup("example.com", "nodeinfo", value));
+            REQUIRE(value == "{}");
+            REQUIRE_FALSE(registry.lookup("example.com", "instance", value));
+            REQUIRE_FALSE(registry.lookup("example.org", "nodeinfo", value));
+        }
+    }
+
+    WHEN("The time to live is over.")
+    {
+        registry.store("example.com", "nodeinfo", "{}");
+        registry.set_ttl(std::chrono::seconds{0});
+
+        THEN("The metadata is not used anymore.")
+        {
+            REQUIRE_FALSE(registry.lookup("example.com", "nodeinfo", value));
+        }
+    }
+
+    WHEN("An instance is erased.")
+    {
+        registry.store("example.com", "nodeinfo", "{}");
+        registry.erase("example.com");
+
+        THEN("Its metadata is gone.")
+        {
+            REQUIRE_FALSE(registry.lookup("example.com", "nodeinfo", value));
+        }
+    }
+
+    WHEN("The metadata is persisted.")
+    {
+        const auto file{std::filesystem::temp_directory_path()
+                        / "mastodonpp-test-instances"};
+        std::filesystem::remove(file);
+        registry.set_persistence(file.string());
+        registry.store("example.com", "instance", "{\"a\":\n1}");
+        registry.store("example.org", "nodeinfo", "");
+        const bool written_early{std::filesystem::exists(file)};
+        registry.flush();
+
+        InstanceRegistry restarted;
+        restarted.set_ttl(std::chrono::hours{1});
+        restarted.set_persistence(file.string());
+        std::filesystem::remove(file);
+
+        THEN("It is written on flush only.")
+        AND_THEN("It is read back by another registry.")
+        {
+            REQUIRE_FALSE(written_early);
+            REQUIRE(restarted.lookup("example.com", "instance", value));
+            REQUIRE(value == "{\"a\":\n1}");
+            REQUIRE(restarted.lookup("example.org", "nodeinfo", value));
+            REQUIRE(value.empty());
+        }
+    }
+
+    WHEN("The registry is destroyed.")
+    {
+        const auto file{std::filesystem::temp_directory_path()
+                        / "mastodonpp-test-instances-destroyed"};
+        std::filesystem::remove(file);
+        {
+            InstanceRegistry destroyed;
+            destroyed.set_ttl(std::chrono::hours{1});
+            destroyed.set_persistence(file.string());
+            destroyed.store("example.com", "instance", "{}");
+        }
+        registry.set_persistence(file.string());
+        std::filesystem::remove(file);
+
+        THEN("Its metadata was written.")
+        {
+            REQUIRE(registry.lookup("example.com", "instance", value));
+            REQUIRE(value == "{}");
+        }
+    }
+
+    WHEN("The file claims a value larger than the file.")
+    {
+        const auto file{std::filesystem::temp_directory_path()
+                        / "mastodonpp-test-instances-damaged"};
+        {
+            std::ofstream out{file, std::ios::binary | std::ios::trunc};
+            out << "mastodonpp-instances 1\n"
+                << "example.com instance 2000000000 3\n{}\n"
+                << "example.org instance 2000000000 99999999999\n{}";
+        }
+        registry.set_persistence(file.string());
+        registry.set_persistence("");
+        std::filesystem::remove(file);
+
+        THEN("The records before it are read.")
+        AND_THEN("The damaged record is not.")
+        {
+            REQUIRE(registry.lookup("example.com", "instance", value));
+            REQUIRE(value == "{}\n");
+            REQUIRE_FALSE(registry.lookup("example.org", "instance", value));
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,138 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020, 2022 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entities.hpp"
+#include "json.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+SCENARIO("mastodonpp::JSONIndexer and mastodonpp::JSONValue.")
+{
+    const string document{
+        R"([{"id":"1","content":"<p>café \"😀\"</p>",)"
+        R"("sensitive":true,"replies_count":42,"reblog":null,)"
+        R"("account":{"id":"7","acct":"user@example.com"},)"
+        R"("media_attachments":[]}, {"id":"2","reblog":{"id":"3"}}])"};
+    JSONIndexer indexer;
+
+    WHEN("The document is fed in small chunks.")
+    {
+        constexpr size_t chunk_size{3};
+        for (size_t pos{0}; pos < document.size(); pos += chunk_size)
+        {
+            indexer.feed(string_view{document}.substr(pos, chunk_size));
+        }
+        REQUIRE(indexer.complete());
+        const auto nodes{indexer.take_nodes()};
+        const JSONValue json{document, nodes};
+
+        THEN("The values are found.")
+        {
+            REQUIRE(json.type() == json_type::array);
+            REQUIRE(json.size() == 2);
+            REQUIRE(json[0]["account"]["acct"].get_string_view()
+                    == "user@example.com");
+            REQUIRE(json[1]["reblog"]["id"].get_string_view() == "3");
+            REQUIRE(json[0]["replies_count"].get_int() == 42);
+            REQUIRE(json[0]["sensitive"].get_bool());
+            REQUIRE(json[0]["reblog"].is_null());
+            REQUIRE_FALSE(json[0]["missing"].valid());
+            REQUIRE_FALSE(json[2].valid());
+        }
+
+        AND_THEN("Escape sequences are resolved.")
+        {
+            REQUIRE(json[0]["content"].get_string()
+                    == "<p>café \"😀\"</p>");
+        }
+
+        AND_THEN("The entity views work.")
+        {
+            vector<string_view> ids;
+            for (const auto &element : json)
+            {
+                const StatusView status{element};
+                ids.push_back(status.id());
+            }
+            const StatusView status{json[0]};
+            REQUIRE(ids == vector<string_view>{"1", "2"});
+            REQUIRE(status.account().acct() == "user@example.com");
+            REQUIRE(status.replies_count() == 42);
+            REQUIRE_FALSE(status.reblog());
+            REQUIRE(StatusView{json[1]}.reblog().id() == "3");
+            REQUIRE(status.media_attachments().size() == 0);
+        }
+    }
+
+    WHEN("The brackets do not match.")
+    {
+        indexer.feed(R"({"id":"1"])");
+
+        THEN("The index is empty.")
+        {
+            REQUIRE_FALSE(indexer.complete());
+            REQUIRE(indexer.take_nodes().empty());
+        }
+    }
+}
+
+SCENARIO("mastodonpp::json_extract().")
+{
+    const string document{
+        R"({ "version" : "2.0", "metadata": {"nodeName": "x\"y",)"
+        R"( "postFormats": ["text/plain", "text/html"], "x": [{}]},)"
+        R"( "max_toot_chars":5000})"};
+
+    WHEN("Values are extracted.")
+    {
+        auto formats{json_extract(document, "metadata.postFormats")};
+        vector<string> elements;
+        string_view element;
+        while (json_next_element(formats, element))
+        {
+            elements.push_back(json_to_string(element));
+        }
+
+        THEN("They are found, at any depth.")
+        AND_THEN("Missing values are empty.")
+        {
+            REQUIRE(json_extract(document, "max_toot_chars") == "5000");
+            REQUIRE(json_to_string(json_extract(document, "metadata.nodeName"))
+                    == "x\"y");
+            REQUIRE(elements == vector<string>{"text/plain", "text/html"});
+            REQUIRE(json_extract(document, "metadata.missing").empty());
+            REQUIRE(json_extract(document, "version.x").empty());
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,186 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance.hpp"
+#include "loopback_server.hpp"
+#include "paginator.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::atomic;
+using std::string;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace
+{
+
+//! Returns page @a number of @a last, with a link to the next one.
+answer_type make_page(const size_t number, const size_t last)
+{
+    answer_type answer;
+    answer.http_status = 200;
+    answer.body = '[' + std::to_string(number) + ']';
+    answer.headers = "HTTP/1.1 200\r\n";
+    if (number < last)
+    {
+        answer.headers += "Link: <https://example.com/api/v1/timelines/home"
+                          "?max_id="
+                          + std::to_string(number + 1)
+                          + R"(>; rel="next")" + "\r\n";
+    }
+    return answer;
+}
+
+//! Returns the page that the parameters ask for, counting the calls.
+page_fetcher make_fetcher(atomic<size_t> &calls, const size_t last)
+{
+    return [&calls, last](const parametermap &parameters)
+    {
+        ++calls;
+        const auto it{parameters.find("max_id")};
+        if (it == parameters.end())
+        {
+            return make_page(1, last);
+        }
+        return make_page(std::stoul(string{std::get<string_view>(it->second)}),
+                         last);
+    };
+}
+
+//! Wait until @a calls reaches @a expected, or 5 seconds.
+void wait_for(const atomic<size_t> &calls, const size_t expected)
+{
+    const auto timeout{steady_clock::now() + seconds{5}};
+    while (calls < expected && steady_clock::now() < timeout)
+    {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+    // Give the background thread the chance to fetch too much.
+    std::this_thread::sleep_for(milliseconds{50});
+}
+
+} // namespace
+
+SCENARIO("mastodonpp::Paginator")
+{
+    atomic<size_t> calls{0};
+
+    WHEN("All pages are taken.")
+    {
+        Paginator paginator{make_fetcher(calls, 3), {{"limit", "1"}}};
+        vector<string> bodies;
+        for (const auto &page : paginator)
+        {
+            bodies.push_back(page.body);
+        }
+
+        THEN("Every page is returned once, in order.")
+        {
+            REQUIRE(bodies == vector<string>{"[1]", "[2]", "[3]"});
+            REQUIRE(calls == 3);
+        }
+    }
+
+    WHEN("Pages are not taken.")
+    {
+        Paginator paginator{make_fetcher(calls, 10), {}, 2};
+        wait_for(calls, 2);
+        const size_t before{calls};
+        answer_type page;
+        REQUIRE(paginator.next_page(page));
+        wait_for(calls, 3);
+
+        THEN("Only depth pages are fetched ahead.")
+        {
+            REQUIRE(before == 2);
+            REQUIRE(page.body == "[1]");
+            REQUIRE(calls == 3);
+        }
+    }
+
+    WHEN("The stop condition is met.")
+    {
+        Paginator paginator{make_fetcher(calls, 10), {}, 1,
+                            [](const answer_type &page)
+                            { return page.body == "[2]"; }};
+        vector<string> bodies;
+        for (const auto &page : paginator)
+        {
+            bodies.push_back(page.body);
+        }
+
+        THEN("The Paginator stops after that page.")
+        {
+            REQUIRE(bodies == vector<string>{"[1]", "[2]"});
+            REQUIRE(calls == 2);
+        }
+    }
+
+    WHEN("The Paginator is destroyed before all pages are taken.")
+    {
+        {
+            Paginator paginator{make_fetcher(calls, 10), {}, 3};
+            wait_for(calls, 1);
+        }
+        const size_t after{calls};
+        std::this_thread::sleep_for(milliseconds{50});
+
+        THEN("No more pages are fetched.")
+        {
+            REQUIRE(after <= 3);
+            REQUIRE(calls == after);
+        }
+    }
+
+#ifdef MASTODONPP_HAVE_LOOPBACK_SERVER
+    WHEN("The Paginator is destroyed while a request hangs.")
+    {
+        LoopbackServer server{0};
+        Instance instance{server.hostname(), {}};
+        const auto before{steady_clock::now()};
+        {
+            Paginator paginator{instance, "/api/v1/timelines/home", {}};
+            std::this_thread::sleep_for(milliseconds{100});
+        }
+        const auto duration{steady_clock::now() - before};
+
+        THEN("The request is aborted.")
+        {
+            REQUIRE(duration < seconds{5});
+        }
+    }
+#endif // MASTODONPP_HAVE_LOOPBACK_SERVER
+}
+
+} // namespace mastodonpp
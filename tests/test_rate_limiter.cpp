@@ -0,0 +1,147 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rate_limiter.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <chrono>
+#include <string>
+
+namespace mastodonpp
+{
+
+using std::string;
+using std::chrono::hours;
+using std::chrono::steady_clock;
+
+namespace
+{
+
+answer_type make_answer(const uint16_t status, const string &limit,
+                        const string &remaining)
+{
+    answer_type answer;
+    answer.http_status = status;
+    answer.headers = "HTTP/1.1 " + std::to_string(status)
+                     + "\r\nX-RateLimit-Limit: " + limit
+                     + "\r\nX-RateLimit-Remaining: " + remaining
+                     + "\r\nX-RateLimit-Reset: 2099-01-01T00:00:00.000Z\r\n";
+    return answer;
+}
+
+} // namespace
+
+SCENARIO("mastodonpp::RateLimiter")
+{
+    WHEN("The same hostname and access token are requested twice.")
+    {
+        const auto first{RateLimiter::get("example.com", "token")};
+        const auto second{RateLimiter::get("example.com", "token")};
+        const auto other{RateLimiter::get("example.com", "other")};
+
+        THEN("The same RateLimiter is returned.")
+        AND_THEN("Another access token gets another RateLimiter.")
+        {
+            REQUIRE(first == second);
+            REQUIRE(first != other);
+        }
+    }
+
+    WHEN("A RateLimiter is not used anymore.")
+    {
+        auto limiter{RateLimiter::get("unused.example", "token")};
+        static_cast<void>(limiter->reserve());
+        limiter->release({});
+        limiter.reset();
+        const auto again{RateLimiter::get("unused.example", "token")};
+
+        THEN("A new one is created.")
+        {
+            REQUIRE(again->get_metrics().requests == 0);
+        }
+    }
+
+    WHEN("Nothing is known about the limit.")
+    {
+        const auto limiter{RateLimiter::get("unknown.example", "")};
+        const auto now{steady_clock::now()};
+        const auto slot{limiter->reserve()};
+        limiter->release({});
+
+        THEN("The request is sent immediately.")
+        {
+            REQUIRE(slot <= steady_clock::now());
+            REQUIRE(slot >= now);
+            REQUIRE(limiter->get_metrics().delayed == 0);
+        }
+    }
+
+    WHEN("Enough requests are left.")
+    {
+        const auto limiter{RateLimiter::get("plenty.example", "")};
+        limiter->release(make_answer(200, "300", "299"));
+        const auto slot{limiter->reserve()};
+        limiter->release(make_answer(200, "300", "298"));
+
+        THEN("The request is sent immediately.")
+        {
+            REQUIRE(slot <= steady_clock::now());
+            const auto metrics{limiter->get_metrics()};
+            REQUIRE(metrics.limit == 300);
+            REQUIRE(metrics.remaining == 298);
+        }
+    }
+
+    WHEN("Few requests are left.")
+    {
+        const auto limiter{RateLimiter::get("few.example", "")};
+        limiter->release(make_answer(200, "300", "3"));
+        const auto first{limiter->reserve()};
+        const auto second{limiter->reserve()};
+
+        THEN("The requests are spread until the reset.")
+        {
+            REQUIRE(first <= steady_clock::now());
+            REQUIRE(second > steady_clock::now() + hours{1});
+            REQUIRE(limiter->get_metrics().delayed == 1);
+            REQUIRE(limiter->get_metrics().queued == 1);
+        }
+    }
+
+    WHEN("The server rejects a request.")
+    {
+        const auto limiter{RateLimiter::get("rejecting.example", "")};
+        static_cast<void>(limiter->reserve());
+        limiter->release(make_answer(429, "300", "0"));
+        const auto slot{limiter->reserve()};
+
+        THEN("The rejection is counted.")
+        AND_THEN("The next request waits for the reset.")
+        {
+            REQUIRE(limiter->get_metrics().rejected == 1);
+            REQUIRE(slot > steady_clock::now() + hours{1});
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,164 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "response_cache.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <filesystem>
+#include <string>
+
+namespace mastodonpp
+{
+
+using std::string;
+
+namespace
+{
+
+answer_type make_answer(const uint16_t status, const string &cache_control,
+                        const string &body)
+{
+    answer_type answer;
+    answer.http_status = status;
+    answer.headers = "HTTP/1.1 " + std::to_string(status)
+                     + "\r\nETag: \"v1\"\r\nCache-Control: " + cache_control
+                     + "\r\n";
+    answer.body = body;
+    return answer;
+}
+
+} // namespace
+
+SCENARIO("mastodonpp::ResponseCache")
+{
+    const auto key{ResponseCache::make_key("https://example.com/", "token")};
+    cache_entry entry;
+
+    WHEN("A key is made.")
+    {
+        THEN("The access token is not in it.")
+        {
+            REQUIRE(key.find("token") == string::npos);
+            REQUIRE(key != ResponseCache::make_key("https://example.com/", ""));
+        }
+    }
+
+    WHEN("A fresh answer is stored in a MemoryCache.")
+    {
+        MemoryCache cache{2};
+        const auto answer{cache.update(
+            key, make_answer(200, "max-age=60", "[1]"), nullptr)};
+
+        THEN("It is returned without asking the server.")
+        {
+            REQUIRE(answer.body == "[1]");
+            REQUIRE(cache.lookup(key, entry));
+            REQUIRE(entry.fresh());
+            REQUIRE(entry.answer.body == "[1]");
+            REQUIRE(cache.get_metrics().hits == 1);
+            REQUIRE(cache.get_metrics().misses == 1);
+        }
+    }
+
+    WHEN("An answer has to be revalidated.")
+    {
+        MemoryCache cache;
+        static_cast<void>(
+            cache.update(key, make_answer(200, "no-cache", "[1]"), nullptr));
+        const bool cached{cache.lookup(key, entry)};
+        const bool fresh{entry.fresh()};
+        const auto headers{entry.conditional_headers()};
+        const auto answer{
+            cache.update(key, make_answer(304, "no-cache", ""), &entry)};
+
+        THEN("It is found, but not fresh.")
+        AND_THEN("The stored answer is returned after 304.")
+        {
+            REQUIRE(cached);
+            REQUIRE_FALSE(fresh);
+            REQUIRE(headers.size() == 1);
+            REQUIRE(headers[0] == "If-None-Match: \"v1\"");
+            REQUIRE(answer.http_status == 200);
+            REQUIRE(answer.body == "[1]");
+            REQUIRE(cache.get_metrics().hits == 0);
+            REQUIRE(cache.get_metrics().revalidated == 1);
+        }
+    }
+
+    WHEN("An answer must not be stored.")
+    {
+        MemoryCache cache;
+        static_cast<void>(
+            cache.update(key, make_answer(200, "no-store", "[1]"), nullptr));
+
+        THEN("It is not stored.")
+        {
+            REQUIRE_FALSE(cache.lookup(key, entry));
+        }
+    }
+
+    WHEN("A MemoryCache is full.")
+    {
+        MemoryCache cache{2};
+        for (const string uri : {"/1", "/2", "/3"})
+        {
+            static_cast<void>(cache.update(
+                ResponseCache::make_key(uri, ""),
+                make_answer(200, "max-age=60", uri), nullptr));
+        }
+
+        THEN("The least recently used answer is removed.")
+        {
+            REQUIRE_FALSE(
+                cache.lookup(ResponseCache::make_key("/1", ""), entry));
+            REQUIRE(cache.lookup(ResponseCache::make_key("/3", ""), entry));
+            REQUIRE(cache.get_metrics().evicted == 1);
+        }
+    }
+
+    WHEN("An answer is stored in a DiskCache.")
+    {
+        const auto directory{std::filesystem::temp_directory_path()
+                             / "mastodonpp-test-cache"};
+        std::filesystem::remove_all(directory);
+        {
+            DiskCache cache{directory.string()};
+            static_cast<void>(cache.update(
+                key, make_answer(200, "max-age=60", "[1]"), nullptr));
+        }
+        DiskCache cache{directory.string()};
+        const bool cached{cache.lookup(key, entry)};
+        std::filesystem::remove_all(directory);
+
+        THEN("It is found by another DiskCache.")
+        {
+            REQUIRE(cached);
+            REQUIRE(entry.fresh());
+            REQUIRE(entry.answer.http_status == 200);
+            REQUIRE(entry.answer.body == "[1]");
+            REQUIRE(entry.answer.get_header("ETag") == "\"v1\"\r");
+        }
+    }
+}
+
+} // namespace mastodonpp
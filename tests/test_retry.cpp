@@ -0,0 +1,196 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "api.hpp"
+#include "connection.hpp"
+#include "dispatcher.hpp"
+#include "instance.hpp"
+#include "retry.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <chrono>
+#include <memory>
+
+namespace mastodonpp
+{
+
+using std::make_shared;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace
+{
+
+answer_type make_answer(const uint16_t status)
+{
+    answer_type answer;
+    answer.http_status = status;
+    return answer;
+}
+
+} // namespace
+
+SCENARIO("mastodonpp::RetryState")
+{
+    retry_policy policy;
+    policy.max_attempts = 3;
+    policy.initial_backoff = milliseconds{100};
+    policy.jitter = false;
+    const auto budget{make_shared<RetryBudget>(policy)};
+
+    WHEN("A GET request fails with HTTP status 503 again and again.")
+    {
+        RetryState retry{policy, budget, http_method::GET};
+        const auto before{steady_clock::now()};
+        const bool first{retry.retry(make_answer(503))};
+        const auto first_attempt{retry.next_attempt()};
+        const auto before_second{steady_clock::now()};
+        const bool second{retry.retry(make_answer(503))};
+        const auto second_attempt{retry.next_attempt()};
+        const bool third{retry.retry(make_answer(503))};
+
+        THEN("It is repeated until max_attempts is reached.")
+        AND_THEN("The backoff doubles.")
+        {
+            REQUIRE(first);
+            REQUIRE(second);
+            REQUIRE_FALSE(third);
+            REQUIRE(retry.get_attempts() == 3);
+            REQUIRE(first_attempt - before >= milliseconds{100});
+            REQUIRE(second_attempt - before_second >= milliseconds{200});
+            REQUIRE(budget->get_metrics().retries == 2);
+        }
+    }
+
+    WHEN("A request succeeds or fails permanently.")
+    {
+        RetryState retry{policy, budget, http_method::GET};
+
+        THEN("It is not repeated.")
+        {
+            REQUIRE_FALSE(retry.retry(make_answer(200)));
+            REQUIRE_FALSE(retry.retry(make_answer(404)));
+        }
+    }
+
+    WHEN("A POST request fails.")
+    {
+        RetryState retry{policy, budget, http_method::POST};
+        answer_type refused;
+        refused.curl_error_code = CURLE_COULDNT_CONNECT;
+
+        THEN("It is only repeated if it was certainly not processed.")
+        {
+            REQUIRE_FALSE(retry.retry(make_answer(503)));
+            REQUIRE(retry.retry(make_answer(429)));
+            REQUIRE(retry.retry(refused));
+        }
+    }
+
+    WHEN("The server sends Retry-After.")
+    {
+        RetryState retry{policy, budget, http_method::GET};
+        auto answer{make_answer(429)};
+        answer.headers = "HTTP/1.1 429\r\nRetry-After: 2\r\n";
+        const auto before{steady_clock::now()};
+
+        THEN("At least that long is waited.")
+        {
+            REQUIRE(retry.retry(answer));
+            REQUIRE(retry.next_attempt() - before >= seconds{2});
+        }
+    }
+
+    WHEN("The wait would end after the deadline.")
+    {
+        policy.deadline = milliseconds{50};
+        RetryState retry{policy, budget, http_method::GET};
+
+        THEN("The request is not repeated.")
+        {
+            REQUIRE_FALSE(retry.retry(make_answer(503)));
+            REQUIRE(retry.time_left() > milliseconds{0});
+            REQUIRE(retry.time_left() <= milliseconds{50});
+        }
+    }
+
+    WHEN("The budget is used up.")
+    {
+        policy.budget_reserve = 1;
+        const auto small_budget{make_shared<RetryBudget>(policy)};
+        RetryState first{policy, small_budget, http_method::GET};
+        RetryState second{policy, small_budget, http_method::GET};
+
+        THEN("Retries are denied.")
+        {
+            REQUIRE(first.retry(make_answer(503)));
+            REQUIRE_FALSE(second.retry(make_answer(503)));
+            REQUIRE(small_budget->get_metrics().requests == 2);
+            REQUIRE(small_budget->get_metrics().denied == 1);
+        }
+    }
+}
+
+SCENARIO("mastodonpp::Connection and mastodonpp::Dispatcher retry.")
+{
+    // Fails without network access.
+    Instance instance{"mastodonpp.invalid", {}};
+    retry_policy policy;
+    policy.max_attempts = 3;
+    policy.initial_backoff = milliseconds{1};
+    policy.jitter = false;
+    policy.deadline = seconds{10};
+
+    WHEN("A Connection requests from an unresolvable host.")
+    {
+        Connection connection{instance};
+        connection.set_timeout(seconds{5});
+        connection.set_retry_policy(policy);
+        const auto answer{connection.get(API::v1::instance)};
+
+        THEN("The request is attempted 3 times.")
+        {
+            REQUIRE(answer.curl_error_code == CURLE_COULDNT_RESOLVE_HOST);
+            REQUIRE(connection.get_retry_metrics().requests == 1);
+            REQUIRE(connection.get_retry_metrics().retries == 2);
+        }
+    }
+
+    WHEN("A Dispatcher requests from an unresolvable host.")
+    {
+        Dispatcher dispatcher{instance};
+        dispatcher.set_timeout(seconds{5});
+        dispatcher.set_retry_policy(policy);
+        const auto answer{
+            dispatcher.submit(http_method::GET, API::v1::instance, {}).get()};
+
+        THEN("The request is attempted 3 times.")
+        {
+            REQUIRE(answer.curl_error_code == CURLE_COULDNT_RESOLVE_HOST);
+            REQUIRE(dispatcher.get_retry_metrics().requests == 1);
+            REQUIRE(dispatcher.get_retry_metrics().retries == 2);
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,188 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance.hpp"
+#include "loopback_server.hpp"
+#include "response_cache.hpp"
+#include "shared_connection.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mastodonpp
+{
+
+SCENARIO("mastodonpp::SharedConnection.")
+{
+    bool exception = false;
+
+    WHEN("SharedConnection is instantiated.")
+    {
+        try
+        {
+            Instance instance{"example.com", {}};
+            SharedConnection connection{instance, 4};
+            connection.set_json_indexing(true);
+
+            THEN("The pool is empty")
+            {
+                REQUIRE(connection.get_connections() == 0);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        {
+            REQUIRE_FALSE(exception);
+        }
+    }
+}
+
+namespace
+{
+
+constexpr size_t threads{8};
+constexpr size_t requests_per_thread{4};
+
+//! Make requests from many threads and return the number of answers.
+size_t run_threads(SharedConnection &connection)
+{
+    std::atomic<size_t> answered{0};
+    std::vector<std::thread> workers;
+    for (size_t i{0}; i < threads; ++i)
+    {
+        workers.emplace_back(
+            [&connection, &answered, i]
+            {
+                for (size_t j{0}; j < requests_per_thread; ++j)
+                {
+                    const auto answer{
+                        (i + j) % 2 == 0
+                            ? connection.get("/api/v1/instance")
+                            : connection.post("/api/v1/statuses",
+                                              {{"status", "Hi"}})};
+                    if (answer.curl_error_code != 0)
+                    {
+                        ++answered;
+                    }
+                }
+            });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    return answered;
+}
+
+} // namespace
+
+SCENARIO("mastodonpp::SharedConnection is used by many threads.")
+{
+    // The host does not exist, so the requests fail fast without network.
+    Instance instance{"mastodonpp.invalid", {}};
+
+    WHEN("8 threads make 4 requests each, with at most 3 Connections.")
+    {
+        constexpr size_t max_connections{3};
+        SharedConnection connection{instance, max_connections};
+        const auto answered{run_threads(connection)};
+
+        THEN("Every request returns")
+        {
+            REQUIRE(answered == threads * requests_per_thread);
+        }
+
+        THEN("The pool is not larger than the maximum")
+        {
+            REQUIRE(connection.get_connections() >= 1);
+            REQUIRE(connection.get_connections() <= max_connections);
+        }
+    }
+
+    WHEN("A response cache is set after the only Connection was pooled.")
+    {
+        SharedConnection connection{instance, 1};
+        run_threads(connection);
+        auto cache{std::make_shared<MemoryCache>()};
+        connection.set_response_cache(cache);
+        connection.set_json_indexing(true);
+        const auto answered{run_threads(connection)};
+
+        THEN("The pooled Connection uses it")
+        {
+            REQUIRE(answered == threads * requests_per_thread);
+            REQUIRE(connection.get_connections() == 1);
+            // Every GET looks into the cache and misses.
+            REQUIRE(cache->get_metrics().misses
+                    == threads * requests_per_thread / 2);
+        }
+    }
+
+    WHEN("Retries are enabled with a budget of 2 retries.")
+    {
+        SharedConnection connection{instance, 3};
+        retry_policy policy;
+        policy.max_attempts = 2;
+        policy.initial_backoff = std::chrono::milliseconds{1};
+        policy.budget_ratio = 0;
+        policy.budget_reserve = 2;
+        connection.set_retry_policy(policy);
+        const auto answered{run_threads(connection)};
+        const auto metrics{connection.get_retry_metrics()};
+
+        THEN("All Connections share the budget")
+        {
+            REQUIRE(answered == threads * requests_per_thread);
+            REQUIRE(metrics.requests == threads * requests_per_thread);
+            REQUIRE(metrics.retries == 2);
+        }
+    }
+
+#ifdef MASTODONPP_HAVE_LOOPBACK_SERVER
+    WHEN("A timeout is set and the server does not answer.")
+    {
+        LoopbackServer server{0};
+        Instance hanging{server.hostname(), {}};
+        SharedConnection connection{hanging};
+        connection.set_timeout(std::chrono::milliseconds{200});
+        const auto answer{connection.get("/api/v1/instance")};
+
+        THEN("The request times out")
+        {
+            REQUIRE(answer.curl_error_code == CURLE_OPERATION_TIMEDOUT);
+        }
+    }
+#endif // MASTODONPP_HAVE_LOOPBACK_SERVER
+}
+
+} // namespace mastodonpp
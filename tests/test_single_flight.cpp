@@ -0,0 +1,113 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "single_flight.hpp"
+#include "types.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::async;
+using std::atomic;
+using std::future;
+using std::promise;
+using std::runtime_error;
+using std::vector;
+
+SCENARIO("mastodonpp::SingleFlight")
+{
+    SingleFlight single_flight;
+    atomic<int> requests{0};
+    promise<void> release;
+    auto released{release.get_future().share()};
+    const auto request{[&requests, released]
+                       {
+                           ++requests;
+                           released.wait();
+                           answer_type answer;
+                           answer.http_status = 200;
+                           answer.body = "[]";
+                           return answer;
+                       }};
+
+    WHEN("Identical requests run at the same time.")
+    {
+        vector<future<answer_type>> answers;
+        for (int i{0}; i < 4; ++i)
+        {
+            answers.push_back(
+                async(std::launch::async, [&single_flight, &request]
+                      { return single_flight.run("a", request); }));
+        }
+        while (single_flight.get_metrics().shared < 3)
+        {
+            std::this_thread::yield();
+        }
+        release.set_value();
+
+        THEN("Only one request is made and all get the answer.")
+        {
+            for (auto &answer : answers)
+            {
+                REQUIRE(answer.get().body == "[]");
+            }
+            REQUIRE(requests == 1);
+            REQUIRE(single_flight.get_metrics().sent == 1);
+        }
+    }
+
+    WHEN("Different requests run at the same time.")
+    {
+        release.set_value();
+        const auto first{single_flight.run("a", request)};
+        const auto second{single_flight.run("b", request)};
+        const auto third{single_flight.run("a", request)};
+
+        THEN("Each is made.")
+        AND_THEN("Requests after the answer are made again.")
+        {
+            REQUIRE(requests == 3);
+            REQUIRE(single_flight.get_metrics().shared == 0);
+        }
+    }
+
+    WHEN("The request throws an exception.")
+    {
+        THEN("It is rethrown.")
+        {
+            REQUIRE_THROWS_AS(single_flight.run("a",
+                                                []() -> answer_type {
+                                                    throw runtime_error{"x"};
+                                                }),
+                              runtime_error);
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,155 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spsc_queue.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace mastodonpp
+{
+
+using std::make_unique;
+using std::size_t;
+using std::thread;
+using std::unique_ptr;
+
+SCENARIO("mastodonpp::SPSCQueue")
+{
+    SPSCQueue<int> queue{3};
+    int value{0};
+
+    WHEN("The queue is empty.")
+    {
+        THEN("pop() fails.")
+        {
+            REQUIRE_FALSE(queue.pop(value));
+        }
+    }
+
+    WHEN("The queue is filled up.")
+    {
+        // The capacity is rounded up to 4.
+        for (int i{0}; i < 4; ++i)
+        {
+            REQUIRE(queue.push(int{i}));
+        }
+        int rejected{4};
+        const bool pushed{queue.push(std::move(rejected))};
+
+        THEN("push() fails.")
+        AND_THEN("The elements come out in order.")
+        {
+            REQUIRE_FALSE(pushed);
+            for (int i{0}; i < 4; ++i)
+            {
+                REQUIRE(queue.pop(value));
+                REQUIRE(value == i);
+            }
+            REQUIRE_FALSE(queue.pop(value));
+        }
+    }
+
+    WHEN("The queue wraps around many times.")
+    {
+        bool in_order{true};
+        for (int i{0}; i < 100; ++i)
+        {
+            REQUIRE(queue.push(int{i}));
+            REQUIRE(queue.push(int{i + 1000}));
+            REQUIRE(queue.pop(value));
+            in_order = in_order && value == i;
+            REQUIRE(queue.pop(value));
+            in_order = in_order && value == i + 1000;
+        }
+
+        THEN("Every element comes out once, in order.")
+        {
+            REQUIRE(in_order);
+            REQUIRE_FALSE(queue.pop(value));
+        }
+    }
+
+    WHEN("A rejected value is pushed.")
+    {
+        SPSCQueue<unique_ptr<int>> pointers{1};
+        REQUIRE(pointers.push(make_unique<int>(1)));
+        auto second{make_unique<int>(2)};
+        const bool pushed{pointers.push(std::move(second))};
+
+        THEN("It is not moved from.")
+        {
+            REQUIRE_FALSE(pushed);
+            REQUIRE(second);
+            REQUIRE(*second == 2);
+        }
+    }
+
+    WHEN("A producer and a consumer thread run at the same time.")
+    {
+        constexpr size_t count{100000};
+        SPSCQueue<size_t> numbers{64};
+        thread producer{[&numbers]
+                        {
+                            for (size_t i{0}; i < count;)
+                            {
+                                size_t number{i};
+                                if (numbers.push(std::move(number)))
+                                {
+                                    ++i;
+                                }
+                                else
+                                {
+                                    std::this_thread::yield();
+                                }
+                            }
+                        }};
+
+        size_t received{0};
+        bool in_order{true};
+        while (received < count)
+        {
+            size_t number{0};
+            if (numbers.pop(number))
+            {
+                in_order = in_order && number == received;
+                ++received;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        size_t extra{0};
+
+        THEN("Every element arrives once, in order.")
+        {
+            REQUIRE(in_order);
+            REQUIRE_FALSE(numbers.pop(extra));
+        }
+    }
+}
+
+} // namespace mastodonpp
@@ -0,0 +1,102 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020, 2022 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sse_parser.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <string_view>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::string_view;
+using std::vector;
+
+SCENARIO("mastodonpp::SSEParser")
+{
+    SSEParser parser;
+    vector<event_type> events;
+
+    WHEN("A stream is fed in one piece.")
+    {
+        parser.feed(":thump\n\nevent: update\ndata: {\"id\":1}\n\n"
+                    "event: delete\ndata: 1\n\n",
+                    events);
+
+        THEN("All events are returned.")
+        AND_THEN("The comment is counted.")
+        {
+            REQUIRE(events.size() == 2);
+            REQUIRE(events[0].type == "update");
+            REQUIRE(events[0].data == "{\"id\":1}");
+            REQUIRE(events[1].type == "delete");
+            REQUIRE(events[1].data == "1");
+            REQUIRE(parser.get_comments() == 1);
+        }
+    }
+
+    WHEN("A stream is fed byte by byte, with CRLF line endings.")
+    {
+        constexpr string_view stream{"event: update\r\nid: 42\r\n"
+                                     "data: line 1\r\ndata:line 2\r\n\r\n"};
+        for (size_t pos{0}; pos < stream.size(); ++pos)
+        {
+            parser.feed(stream.substr(pos, 1), events);
+        }
+
+        THEN("The event is complete.")
+        {
+            REQUIRE(events.size() == 1);
+            REQUIRE(events[0].type == "update");
+            REQUIRE(events[0].data == "line 1\nline 2");
+            REQUIRE(events[0].id == "42");
+        }
+    }
+
+    WHEN("An event is incomplete.")
+    {
+        parser.feed("event: notification\ndata: {", events);
+
+        THEN("It is not returned until the rest arrives.")
+        {
+            REQUIRE(events.empty());
+            parser.feed("}\n\n", events);
+            REQUIRE(events.size() == 1);
+            REQUIRE(events[0].type == "notification");
+            REQUIRE(events[0].data == "{}");
+        }
+    }
+
+    WHEN("An event has no type.")
+    {
+        parser.feed("data: hello\n\n", events);
+
+        THEN("The type is “message”.")
+        {
+            REQUIRE(events.size() == 1);
+            REQUIRE(events[0].type == "message");
+        }
+    }
+}
+
+} // namespace mastodonpp
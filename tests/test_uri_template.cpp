@@ -0,0 +1,86 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020, 2022 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exceptions.hpp"
+#include "uri_template.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <string>
+
+namespace mastodonpp
+{
+
+SCENARIO("mastodonpp::URITemplate.")
+{
+    const URITemplate uri_template{
+        "https://example.com",
+        API{API::pleroma::admin_reports_report_id_notes_id}.get_path()};
+    string uri;
+
+    WHEN("All placeholders are bound.")
+    {
+        uri_template.render({{"report_id", "12"}, {"id", "3"}, {"x", "y"}},
+                            uri);
+
+        THEN("The URI is complete.")
+        AND_THEN("Only bound parameters are recognized.")
+        {
+            REQUIRE(uri == "https://example.com/api/pleroma/admin/reports/12"
+                           "/notes/3");
+            REQUIRE(uri_template.binds("report_id"));
+            REQUIRE_FALSE(uri_template.binds("x"));
+        }
+    }
+
+    WHEN("A placeholder is not bound.")
+    {
+        bool exception = false;
+        try
+        {
+            uri_template.render({{"report_id", "12"}}, uri);
+        }
+        catch (const CURLException &e)
+        {
+            exception = true;
+        }
+
+        THEN("An exception is thrown.")
+        {
+            REQUIRE(exception);
+        }
+    }
+
+    WHEN("A literal template is rendered.")
+    {
+        const auto literal{
+            URITemplate::literal("https://example.com/<ID>/<unclosed")};
+        literal.render({{"id", "1"}}, uri);
+
+        THEN("The URI is unchanged.")
+        {
+            REQUIRE(uri == "https://example.com/<ID>/<unclosed");
+            REQUIRE_FALSE(literal.binds("id"));
+        }
+    }
+}
+
+} // namespace mastodonpp
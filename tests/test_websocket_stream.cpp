@@ -0,0 +1,258 @@
+/*  This file is part of mastodonpp.
+ *  Copyright © 2020, 2022 tastytea <tastytea@tastytea.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instance.hpp"
+#include "websocket_stream.hpp"
+
+// catch 3 does not have catch.hpp anymore
+#if __has_include(<catch.hpp>)
+#    include <catch.hpp>
+#else
+#    include <catch_all.hpp>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mastodonpp
+{
+
+using std::deque;
+using std::pair;
+using std::string;
+using std::vector;
+
+//! Replaces the network with queues of frames.
+class LoopbackWebSocket : public WebSocketStream
+{
+public:
+    using WebSocketStream::WebSocketStream;
+
+    LoopbackWebSocket(const LoopbackWebSocket &other) = delete;
+    LoopbackWebSocket(LoopbackWebSocket &&other) noexcept = delete;
+    LoopbackWebSocket &operator=(const LoopbackWebSocket &other) = delete;
+    LoopbackWebSocket &operator=(LoopbackWebSocket &&other) noexcept = delete;
+
+    ~LoopbackWebSocket() noexcept override
+    {
+        close();
+    }
+
+    //! Queue a part of a message. The message ends with the last part.
+    void feed(const string_view data, const bool last = true)
+    {
+        _incoming.emplace_back(string{data}, last);
+    }
+
+    //! Queue a frame that closes the connection.
+    void feed_close()
+    {
+        _incoming.emplace_back(string{}, true);
+        _close_after = _incoming.size();
+    }
+
+    vector<string> sent;
+    bool closed{false};
+
+protected:
+    answer_type handshake(string_view /*uri*/) override
+    {
+        answer_type answer;
+        answer.http_status = 101;
+        return answer;
+    }
+
+    CURLcode receive(char *buffer, const size_t size,
+                     frame_part &part) override
+    {
+        if (_incoming.empty())
+        {
+            return CURLE_AGAIN;
+        }
+        ++_received;
+        if (_received == _close_after)
+        {
+            _incoming.pop_front();
+            part.type = frame_type::close;
+            return CURLE_OK;
+        }
+
+        auto &[data, last]{_incoming.front()};
+        part.size = std::min(size, data.size());
+        std::memcpy(buffer, data.data(), part.size);
+        part.type = frame_type::data;
+        part.last = last;
+        _incoming.pop_front();
+
+        return CURLE_OK;
+    }
+
+    CURLcode send_text(const string_view text, size_t &sent_bytes) override
+    {
+        sent.emplace_back(text);
+        sent_bytes = text.size();
+        return CURLE_OK;
+    }
+
+    void send_close() override
+    {
+        closed = true;
+    }
+
+    bool wait_for_socket(bool /*write*/, milliseconds /*timeout*/) override
+    {
+        return !_incoming.empty();
+    }
+
+private:
+    deque<pair<string, bool>> _incoming;
+    size_t _received{0};
+    size_t _close_after{0};
+};
+
+SCENARIO("mastodonpp::WebSocketStream.")
+{
+    bool exception = false;
+    bool connected = true;
+
+    WHEN("Streams are subscribed to before connecting.")
+    {
+        try
+        {
+            Instance instance{"example.com", {}};
+            WebSocketStream websocket{instance};
+            websocket.subscribe("hashtag", "test",
+                                [](event_type &&) { return true; });
+            websocket.unsubscribe("hashtag", "test");
+            connected = websocket.is_connected();
+        }
+        catch (const std::exception &e)
+        {
+            exception = true;
+        }
+
+        THEN("No exception is thrown")
+        AND_THEN("The stream is not connected.")
+        {
+            REQUIRE_FALSE(exception);
+            REQUIRE_FALSE(connected);
+        }
+    }
+}
+
+SCENARIO("mastodonpp::WebSocketStream routes events.")
+{
+    Instance instance{"example.com", {}};
+    LoopbackWebSocket websocket{instance};
+    vector<string> hashtag_events;
+    vector<string> user_events;
+    websocket.subscribe("hashtag", "foo", [&](event_type &&event) {
+        hashtag_events.push_back(event.type + ':' + event.data);
+        return true;
+    });
+    websocket.subscribe("user", "", [&](event_type &&event) {
+        user_events.push_back(event.type + ':' + event.data);
+        return true;
+    });
+    websocket.connect("ws://example.com/api/v1/streaming");
+
+    WHEN("The stream connects.")
+    {
+        THEN("The subscriptions are sent.")
+        {
+            REQUIRE(websocket.is_connected());
+            REQUIRE(websocket.sent
+                    == vector<string>{
+                        R"({"type":"subscribe","stream":"hashtag",)"
+                        R"("tag":"foo"})",
+                        R"({"type":"subscribe","stream":"user"})"});
+        }
+    }
+
+    WHEN("Events for both streams arrive.")
+    {
+        websocket.feed(R"({"stream":["hashtag","foo"],"event":"update",)"
+                       R"("payload":"1"})");
+        websocket.feed(R"({"stream":["user"],"event":"notif)", false);
+        websocket.feed(R"(ication","payload":{"id":"2"}})");
+        websocket.feed(R"({"stream":["hashtag","bar"],"event":"update",)"
+                       R"("payload":"3"})");
+        const auto delivered{websocket.poll(milliseconds{0})};
+
+        THEN("Each event reaches its callback.")
+        {
+            REQUIRE(delivered == 2);
+            REQUIRE(hashtag_events == vector<string>{"update:1"});
+            REQUIRE(user_events
+                    == vector<string>{R"(notification:{"id":"2"})"});
+        }
+    }
+
+    WHEN("A stream is unsubscribed from.")
+    {
+        websocket.sent.clear();
+        websocket.unsubscribe("hashtag", "foo");
+        websocket.feed(R"({"stream":["hashtag","foo"],"event":"update",)"
+                       R"("payload":"1"})");
+        websocket.feed(R"({"stream":["user"],"event":"delete",)"
+                       R"("payload":"2"})");
+        const auto delivered{websocket.poll(milliseconds{0})};
+
+        THEN("The unsubscription is sent.")
+        AND_THEN("Nothing is delivered to its callback anymore.")
+        {
+            REQUIRE(websocket.sent
+                    == vector<string>{R"({"type":"unsubscribe",)"
+                                      R"("stream":"hashtag","tag":"foo"})"});
+            REQUIRE(delivered == 1);
+            REQUIRE(hashtag_events.empty());
+            REQUIRE(user_events == vector<string>{"delete:2"});
+        }
+    }
+
+    WHEN("The server closes the connection.")
+    {
+        websocket.feed_close();
+        websocket.feed(R"({"stream":["user"],"event":"delete",)"
+                       R"("payload":"2"})");
+        const auto delivered{websocket.poll(milliseconds{0})};
+
+        THEN("The stream is disconnected.")
+        {
+            REQUIRE(delivered == 0);
+            REQUIRE_FALSE(websocket.is_connected());
+            REQUIRE(user_events.empty());
+        }
+    }
+
+    WHEN("The connection is closed.")
+    {
+        websocket.close();
+
+        THEN("A close frame is sent.")
+        {
+            REQUIRE(websocket.closed);
+            REQUIRE_FALSE(websocket.is_connected());
+        }
+    }
+}
+
+} // namespace mastodonpp